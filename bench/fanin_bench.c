@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2015 Jason Schmidlapp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Many producers into one consumer: DECLARE_FANIN (one simple FIFO per producer, polled
+ * in batches) against DECLARE_MPSC_FIFO (one shared FIFO, producers contend on its
+ * produce_count), from 1 to 64 producer threads.
+ *
+ * Every producer pushes ITEMS_TOTAL / numProducers items; the main thread drains them
+ * and the elapsed time covers the whole transfer.
+ *
+ * Build: cc -O2 -pthread -I.. fanin_bench.c -o fanin_bench
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+
+#include "../fanin.h"
+#include "../mpsc_fifo.h"
+
+#define FIFO_SIZE     1024
+#define ITEMS_TOTAL   4000000
+#define MAX_PRODUCERS 64
+#define POLL_MAX      256
+
+DECLARE_FANIN(uint32_t, bench, MAX_PRODUCERS, FIFO_SIZE)
+DECLARE_MPSC_FIFO(uint32_t, shared, FIFO_SIZE)
+
+static FANIN(bench) fanin;
+static MPSC(shared) mpsc;
+
+static size_t itemsPerProducer;
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void *fanin_producer(void *arg)
+{
+	unsigned id = (unsigned) (size_t) arg;
+	size_t i;
+
+	for (i=0; i<itemsPerProducer; i++) {
+		while (FANIN_Push(bench, &fanin, id, (uint32_t) i) == -EAGAIN)
+			sched_yield();
+	}
+
+	return NULL;
+}
+
+static void *mpsc_producer(void *arg)
+{
+	size_t i;
+
+	for (i=0; i<itemsPerProducer; i++) {
+		while (MPSC_TryPush(shared, &mpsc, (uint32_t) i) == -EAGAIN)
+			sched_yield();
+	}
+
+	return NULL;
+}
+
+static void bench_fanin(size_t numProducers)
+{
+	static uint32_t out[POLL_MAX];
+	pthread_t threads[MAX_PRODUCERS];
+	size_t total = itemsPerProducer * numProducers;
+	size_t received = 0;
+	uint64_t start, elapsed;
+	size_t i;
+
+	FANIN_Init(bench, &fanin);
+
+	start = now_ns();
+	for (i=0; i<numProducers; i++)
+		pthread_create(&threads[i], NULL, fanin_producer, (void *) i);
+
+	while (received < total) {
+		size_t num = FANIN_Poll(bench, &fanin, out, POLL_MAX);
+
+		if (num == 0)
+			sched_yield();
+		received += num;
+	}
+
+	for (i=0; i<numProducers; i++)
+		pthread_join(threads[i], NULL);
+	elapsed = now_ns() - start;
+
+	printf("fanin         producers=%2zu  %8.2f Mitems/s  %6.1f ns/item\n",
+	       numProducers, total / (elapsed / 1e3), (double) elapsed / total);
+}
+
+static void bench_mpsc(size_t numProducers)
+{
+	pthread_t threads[MAX_PRODUCERS];
+	size_t total = itemsPerProducer * numProducers;
+	size_t received = 0;
+	uint64_t start, elapsed;
+	uint32_t val;
+	size_t i;
+
+	MPSC_Init(shared, &mpsc);
+
+	start = now_ns();
+	for (i=0; i<numProducers; i++)
+		pthread_create(&threads[i], NULL, mpsc_producer, NULL);
+
+	while (received < total) {
+		if (MPSC_TryPop(shared, &mpsc, &val) == 0)
+			received++;
+		else
+			sched_yield();
+	}
+
+	for (i=0; i<numProducers; i++)
+		pthread_join(threads[i], NULL);
+	elapsed = now_ns() - start;
+
+	printf("mpsc          producers=%2zu  %8.2f Mitems/s  %6.1f ns/item\n",
+	       numProducers, total / (elapsed / 1e3), (double) elapsed / total);
+}
+
+int main(void)
+{
+	size_t n;
+
+	for (n=1; n<=MAX_PRODUCERS; n*=2) {
+		itemsPerProducer = ITEMS_TOTAL / n;
+		bench_fanin(n);
+		bench_mpsc(n);
+	}
+
+	return 0;
+}
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2015 Jason Schmidlapp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Earliest deadline first queue: DECLARE_HEAP against a LIST kept sorted by walking it
+ * on every insert.
+ *
+ * For each queue depth the queue is filled with random deadlines and then run in steady
+ * state: pop the earliest entry and re-insert it with a later deadline (a periodic timer
+ * re-arming itself).  Reported is the time per pop+insert pair.
+ *
+ * Build: cc -O2 -I.. heap_bench.c ../heap.c -o heap_bench
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../heap.h"
+#include "../list.h"
+
+#define MAX_DEPTH 16384
+#define NUM_OPS   200000
+
+typedef struct {
+	LIST_node_t listNode;
+	HEAP_node_t heapNode;
+	uint64_t    deadline;
+} Timer_t;
+
+DECLARE_HEAP(bench, MAX_DEPTH)
+
+static HEAP(bench) heap;
+static LIST_node_t sortedList;
+static Timer_t timers[MAX_DEPTH];
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void list_insert(Timer_t *timer)
+{
+	LIST_node_t *pos = sortedList.next;
+
+	while ((pos != &sortedList) && (((Timer_t *) pos)->deadline <= timer->deadline))
+		pos = pos->next;
+
+	/* Insert before pos (LIST_Add evaluates its head argument more than once) */
+	pos = pos->prev;
+	LIST_Add(pos, &timer->listNode);
+}
+
+static Timer_t *list_pop(void)
+{
+	Timer_t *timer = (Timer_t *) sortedList.next;
+
+	LIST_Del(&timer->listNode);
+	return timer;
+}
+
+static double bench_heap(size_t depth)
+{
+	uint64_t start, sum = 0;
+	size_t i;
+
+	srand(1);
+	HEAP_Init(bench, &heap);
+	for (i=0; i<depth; i++) {
+		timers[i].heapNode.key = rand() % (depth * 16);
+		HEAP_Insert(bench, &heap, &timers[i].heapNode);
+	}
+
+	start = now_ns();
+	for (i=0; i<NUM_OPS; i++) {
+		HEAP_node_t *node = HEAP_PopMin(bench, &heap);
+
+		sum += node->key;
+		node->key += 1 + rand() % (depth * 16);
+		HEAP_Insert(bench, &heap, node);
+	}
+
+	/* Keeps the loop from being optimized away */
+	if (sum == 0)
+		printf(" ");
+
+	return (double) (now_ns() - start) / NUM_OPS;
+}
+
+static double bench_list(size_t depth)
+{
+	uint64_t start, sum = 0;
+	size_t i;
+
+	srand(1);
+	LIST_Init(&sortedList);
+	for (i=0; i<depth; i++) {
+		timers[i].deadline = rand() % (depth * 16);
+		list_insert(&timers[i]);
+	}
+
+	start = now_ns();
+	for (i=0; i<NUM_OPS; i++) {
+		Timer_t *timer = list_pop();
+
+		sum += timer->deadline;
+		timer->deadline += 1 + rand() % (depth * 16);
+		list_insert(timer);
+	}
+
+	if (sum == 0)
+		printf(" ");
+
+	return (double) (now_ns() - start) / NUM_OPS;
+}
+
+int main(void)
+{
+	size_t depth;
+
+	printf("%8s  %14s  %18s\n", "depth", "heap ns/op", "sorted list ns/op");
+
+	for (depth=16; depth<=MAX_DEPTH; depth*=4)
+		printf("%8zu  %14.1f  %18.1f\n", depth, bench_heap(depth), bench_list(depth));
+
+	return 0;
+}
@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2015 Jason Schmidlapp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Producer contention: 1 to 64 threads pushing into one consumer, comparing
+ * DECLARE_MPSC_FIFO against a simple FIFO whose pushes are serialized by a mutex
+ * (the pattern the MPSC variant replaces).
+ *
+ * Every producer pushes ITEMS_TOTAL / numProducers items; the main thread drains
+ * them and the elapsed time covers the whole transfer.
+ *
+ * Build: cc -O2 -pthread -I.. mpsc_bench.c -o mpsc_bench
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+
+#include "../simple_fifo.h"
+#include "../mpsc_fifo.h"
+
+#define FIFO_SIZE     1024
+#define ITEMS_TOTAL   4000000
+#define MAX_PRODUCERS 64
+
+DECLARE_MPSC_FIFO(uint32_t, bench, FIFO_SIZE)
+DECLARE_SIMPLE_FIFO(uint32_t, locked, FIFO_SIZE)
+
+static MPSC(bench) mpsc;
+static SFIFO(locked) sfifo;
+static pthread_mutex_t sfifoLock = PTHREAD_MUTEX_INITIALIZER;
+
+static size_t itemsPerProducer;
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void *mpsc_producer(void *arg)
+{
+	size_t i;
+
+	for (i=0; i<itemsPerProducer; i++) {
+		while (MPSC_TryPush(bench, &mpsc, (uint32_t) i) == -EAGAIN)
+			sched_yield();
+	}
+
+	return NULL;
+}
+
+static void *locked_producer(void *arg)
+{
+	size_t i;
+
+	for (i=0; i<itemsPerProducer; i++) {
+		for (;;) {
+			int full;
+
+			pthread_mutex_lock(&sfifoLock);
+			full = SFIFO_IsFull(locked, &sfifo);
+			if (!full)
+				SFIFO_Push(locked, &sfifo, (uint32_t) i);
+			pthread_mutex_unlock(&sfifoLock);
+
+			if (!full)
+				break;
+			sched_yield();
+		}
+	}
+
+	return NULL;
+}
+
+static void bench_mpsc(size_t numProducers)
+{
+	pthread_t threads[MAX_PRODUCERS];
+	size_t total = itemsPerProducer * numProducers;
+	size_t received = 0;
+	uint64_t start, elapsed;
+	uint32_t val;
+	size_t i;
+
+	MPSC_Init(bench, &mpsc);
+
+	start = now_ns();
+	for (i=0; i<numProducers; i++)
+		pthread_create(&threads[i], NULL, mpsc_producer, NULL);
+
+	while (received < total) {
+		if (MPSC_TryPop(bench, &mpsc, &val) == 0)
+			received++;
+		else
+			sched_yield();
+	}
+
+	for (i=0; i<numProducers; i++)
+		pthread_join(threads[i], NULL);
+	elapsed = now_ns() - start;
+
+	printf("mpsc          producers=%2zu  %8.2f Mitems/s  %6.1f ns/item\n",
+	       numProducers, total / (elapsed / 1e3), (double) elapsed / total);
+}
+
+static void bench_locked(size_t numProducers)
+{
+	pthread_t threads[MAX_PRODUCERS];
+	size_t total = itemsPerProducer * numProducers;
+	size_t received = 0;
+	uint64_t start, elapsed;
+	size_t i;
+
+	SFIFO_Init(locked, &sfifo);
+
+	start = now_ns();
+	for (i=0; i<numProducers; i++)
+		pthread_create(&threads[i], NULL, locked_producer, NULL);
+
+	/* The consumer side of a simple FIFO needs no lock */
+	while (received < total) {
+		if (!SFIFO_IsEmpty(locked, &sfifo)) {
+			SFIFO_Pop(locked, &sfifo);
+			received++;
+		}
+		else {
+			sched_yield();
+		}
+	}
+
+	for (i=0; i<numProducers; i++)
+		pthread_join(threads[i], NULL);
+	elapsed = now_ns() - start;
+
+	printf("mutex+sfifo   producers=%2zu  %8.2f Mitems/s  %6.1f ns/item\n",
+	       numProducers, total / (elapsed / 1e3), (double) elapsed / total);
+}
+
+int main(void)
+{
+	size_t n;
+
+	for (n=1; n<=MAX_PRODUCERS; n*=2) {
+		itemsPerProducer = ITEMS_TOTAL / n;
+		bench_mpsc(n);
+		bench_locked(n);
+	}
+
+	return 0;
+}
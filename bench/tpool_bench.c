@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2015 Jason Schmidlapp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Throughput and latency of small tasks on the thread pool.
+ *
+ * Throughput: the submitting thread pushes NUM_TASKS empty-ish tasks as fast as it can
+ * and waits for completion, for every worker count from 1 up to the number of cores.
+ *
+ * Latency: one task at a time, measuring the time from TPOOL_Submit until the task
+ * starts running on the worker (includes wake-up from parking after the idle gap).
+ *
+ * Build: cc -O2 -pthread -I.. tpool_bench.c ../threadpool.c -o tpool_bench
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "../threadpool.h"
+
+#define NUM_TASKS       1000000
+#define NUM_LAT_SAMPLES 10000
+
+static TPOOL_t pool;
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void small_task(void *arg)
+{
+	__atomic_fetch_add((uint64_t *) arg, 1, __ATOMIC_RELAXED);
+}
+
+static uint64_t submitTime;
+static uint64_t startTime;
+
+static void latency_task(void *arg)
+{
+	__atomic_store_n(&startTime, now_ns(), __ATOMIC_RELEASE);
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+	return (x > y) - (x < y);
+}
+
+static void bench_throughput(size_t numWorkers, TPOOL_Policy_t policy)
+{
+	static uint64_t counters[TPOOL_MAX_WORKERS * 8];
+	uint64_t start, elapsed;
+	size_t i;
+	int result;
+
+	result = TPOOL_Init(&pool, numWorkers, policy);
+	if (result != 0) {
+		fprintf(stderr, "TPOOL_Init(%zu workers) failed: %d\n", numWorkers, result);
+		return;
+	}
+
+	start = now_ns();
+	for (i=0; i<NUM_TASKS; i++) {
+		/* Spread the counters so the tasks don't all share a cache line */
+		while (TPOOL_Submit(&pool, small_task, &counters[(i % numWorkers) * 8]) == -EAGAIN)
+			sched_yield();
+	}
+	TPOOL_Wait(&pool);
+	elapsed = now_ns() - start;
+
+	TPOOL_Destroy(&pool);
+
+	printf("%-13s workers=%2zu  %8.2f Mtasks/s  %6.1f ns/task\n",
+	       (policy == TPOOL_POLICY_ROUND_ROBIN) ? "round-robin" : "least-loaded",
+	       numWorkers, NUM_TASKS / (elapsed / 1e3), (double) elapsed / NUM_TASKS);
+}
+
+static void bench_latency(size_t numWorkers)
+{
+	static uint64_t samples[NUM_LAT_SAMPLES];
+	size_t i;
+	int result;
+
+	result = TPOOL_Init(&pool, numWorkers, TPOOL_POLICY_LEAST_LOADED);
+	if (result != 0) {
+		fprintf(stderr, "TPOOL_Init(%zu workers) failed: %d\n", numWorkers, result);
+		return;
+	}
+
+	for (i=0; i<NUM_LAT_SAMPLES; i++) {
+		__atomic_store_n(&startTime, 0, __ATOMIC_RELAXED);
+		submitTime = now_ns();
+		TPOOL_Submit(&pool, latency_task, NULL);
+		while (__atomic_load_n(&startTime, __ATOMIC_ACQUIRE) == 0)
+			;
+		samples[i] = startTime - submitTime;
+		TPOOL_Wait(&pool);
+	}
+
+	TPOOL_Destroy(&pool);
+
+	qsort(samples, NUM_LAT_SAMPLES, sizeof(samples[0]), cmp_u64);
+	printf("latency       workers=%2zu  p50 %6llu ns  p99 %6llu ns  max %8llu ns\n", numWorkers,
+	       (unsigned long long) samples[NUM_LAT_SAMPLES / 2],
+	       (unsigned long long) samples[NUM_LAT_SAMPLES * 99 / 100],
+	       (unsigned long long) samples[NUM_LAT_SAMPLES - 1]);
+}
+
+int main(void)
+{
+	long cores = sysconf(_SC_NPROCESSORS_ONLN);
+	size_t maxWorkers = (cores > TPOOL_MAX_WORKERS) ? TPOOL_MAX_WORKERS : (size_t) cores;
+	size_t n;
+
+	for (n=1; n<=maxWorkers; n*=2) {
+		bench_throughput(n, TPOOL_POLICY_ROUND_ROBIN);
+		bench_throughput(n, TPOOL_POLICY_LEAST_LOADED);
+	}
+
+	for (n=1; n<=maxWorkers; n*=2)
+		bench_latency(n);
+
+	return 0;
+}
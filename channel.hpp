@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) 2015 Jason Schmidlapp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef CHANNEL_HPP_
+#define CHANNEL_HPP_
+
+/*
+ * Coroutine channel over cde::spsc_ring.  co_await push() and co_await pop() complete
+ * immediately while the ring has room (or data) and only suspend when it is full (or
+ * empty).  A suspended coroutine is queued on the channel and resumed directly by the
+ * peer that makes progress possible: a pop that frees a slot moves the oldest waiting
+ * push's value into the ring and resumes that pusher; a push that finds a consumer
+ * waiting hands the value straight to it.  No threads are woken and nothing is
+ * scheduled through an executor; resumption is an inline call.
+ *
+ * cde::channel<Request, 64> ch;
+ *
+ * task producer() {
+ *     for (...)
+ *         if (!co_await ch.push(Request(...)))
+ *             break;                         // channel closed
+ *     ch.close();
+ * }
+ *
+ * task consumer() {
+ *     while (auto req = co_await ch.pop())   // std::optional, empty once closed and drained
+ *         handle(*req);
+ * }
+ *
+ * Waiters are served in the order they suspended.  close() wakes every waiter: pending
+ * pushes return false (their values are dropped) and pops return whatever is still
+ * buffered, then an empty optional.
+ *
+ * Single threaded: every coroutine using a channel must run on the same thread (any
+ * number of producers and consumers).  Because a coroutine is resumed on the stack of
+ * the peer that woke it, the stack depth can reach the number of coroutines sharing
+ * the channel.  Requires C++20.
+ */
+
+#include <coroutine>
+#include <cstddef>
+#include <optional>
+#include <utility>
+
+#include "spsc_ring.hpp"
+
+namespace cde {
+
+template <typename T, std::size_t N>
+class channel {
+	/* Intrusive FIFO of suspended awaiters; they live in the waiting coroutine's frame */
+	template <typename W>
+	struct waiter_list {
+		W *head = nullptr;
+		W *tail = nullptr;
+
+		bool empty() const { return head == nullptr; }
+
+		void push_back(W *w)
+		{
+			w->next_ = nullptr;
+			if (tail)
+				tail->next_ = w;
+			else
+				head = w;
+			tail = w;
+		}
+
+		W *pop_front()
+		{
+			W *w = head;
+
+			if (w) {
+				head = w->next_;
+				if (head == nullptr)
+					tail = nullptr;
+			}
+			return w;
+		}
+	};
+
+public:
+	class push_awaiter {
+	public:
+		bool await_ready()
+		{
+			if (ch_.closed_) {
+				ok_ = false;
+				return true;
+			}
+
+			/* A waiting consumer means the ring is empty: hand the value over directly */
+			if (pop_awaiter *w = ch_.poppers_.pop_front()) {
+				w->value_.emplace(std::move(value_));
+				w->handle_.resume();
+				return true;
+			}
+
+			/* Don't overtake pushes already waiting for room */
+			return ch_.pushers_.empty() && ch_.ring_.try_push(std::move(value_));
+		}
+
+		void await_suspend(std::coroutine_handle<> h)
+		{
+			handle_ = h;
+			ch_.pushers_.push_back(this);
+		}
+
+		/* true once the value is in the channel, false if it was closed */
+		bool await_resume() const { return ok_; }
+
+	private:
+		friend class channel;
+		friend struct waiter_list<push_awaiter>;
+
+		push_awaiter(channel &ch, T &&value) : ch_(ch), value_(std::move(value)) {}
+
+		channel                &ch_;
+		T                       value_;
+		bool                    ok_ = true;
+		std::coroutine_handle<> handle_;
+		push_awaiter           *next_ = nullptr;
+	};
+
+	class pop_awaiter {
+	public:
+		bool await_ready()
+		{
+			if (T *front = ch_.ring_.front()) {
+				value_.emplace(std::move(*front));
+				ch_.ring_.pop();
+				ch_.admit_pusher();
+				return true;
+			}
+
+			return ch_.closed_;
+		}
+
+		void await_suspend(std::coroutine_handle<> h)
+		{
+			handle_ = h;
+			ch_.poppers_.push_back(this);
+		}
+
+		std::optional<T> await_resume() { return std::move(value_); }
+
+	private:
+		friend class channel;
+		friend struct waiter_list<pop_awaiter>;
+
+		explicit pop_awaiter(channel &ch) : ch_(ch) {}
+
+		channel                &ch_;
+		std::optional<T>        value_;
+		std::coroutine_handle<> handle_;
+		pop_awaiter            *next_ = nullptr;
+	};
+
+	channel() = default;
+	channel(const channel &) = delete;
+	channel &operator=(const channel &) = delete;
+
+	static constexpr std::size_t capacity() { return N; }
+
+	[[nodiscard]] push_awaiter push(T value) { return push_awaiter(*this, std::move(value)); }
+	[[nodiscard]] pop_awaiter pop() { return pop_awaiter(*this); }
+
+	bool closed() const { return closed_; }
+
+	void close()
+	{
+		closed_ = true;
+
+		while (push_awaiter *w = pushers_.pop_front()) {
+			w->ok_ = false;
+			w->handle_.resume();
+		}
+
+		while (pop_awaiter *w = poppers_.pop_front())
+			w->handle_.resume();
+	}
+
+private:
+	/* A slot was just freed: move the oldest waiting push into it */
+	void admit_pusher()
+	{
+		if (push_awaiter *w = pushers_.pop_front()) {
+			ring_.try_push(std::move(w->value_));
+			w->handle_.resume();
+		}
+	}
+
+	spsc_ring<T, N>           ring_;
+	waiter_list<push_awaiter> pushers_;
+	waiter_list<pop_awaiter>  poppers_;
+	bool                      closed_ = false;
+};
+
+} // namespace cde
+
+#endif // CHANNEL_HPP_
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2015 Jason Schmidlapp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+#include "doorbell.h"
+
+int DOORBELL_Init(DOORBELL_t *db)
+{
+	if (db == NULL)
+		return -EINVAL;
+
+	db->fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (db->fd < 0)
+		return -errno;
+
+	db->armed = 1;
+	db->rings = 0;
+	return 0;
+}
+
+void DOORBELL_Close(DOORBELL_t *db)
+{
+	if ((db == NULL) || (db->fd < 0))
+		return;
+
+	close(db->fd);
+	db->fd = -1;
+}
+
+void DOORBELL_Signal(DOORBELL_t *db)
+{
+	uint64_t one = 1;
+
+	/* Retries an interrupted write; otherwise it can only fail with EAGAIN, when the counter
+	 * is about to overflow, in which case it's readable anyway
+	 */
+	while ((write(db->fd, &one, sizeof(one)) < 0) && (errno == EINTR))
+		;
+	__atomic_fetch_add(&db->rings, 1, __ATOMIC_RELAXED);
+}
+
+/* Clears the eventfd counter so level-triggered epoll stops reporting it */
+void DOORBELL_Ack(DOORBELL_t *db)
+{
+	uint64_t count;
+
+	/* EAGAIN just means nothing rang since the last ack */
+	while ((read(db->fd, &count, sizeof(count)) < 0) && (errno == EINTR))
+		;
+}
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2015 Jason Schmidlapp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef DOORBELL_H_
+#define DOORBELL_H_
+
+/*
+ * eventfd based wakeup for FIFO consumers that sit in an epoll (or poll/select) loop
+ * instead of spinning on SFIFO_IsEmpty.
+ *
+ * The consumer "arms" the doorbell when it has drained the FIFO and is about to go back
+ * to epoll_wait.  A producer rings (writes the eventfd) only if it finds the doorbell
+ * armed, and disarms it in the same step, so a burst of pushes costs one syscall and
+ * one wakeup rather than one per message.  The consumer then drains everything in
+ * batches and only re-arms once the FIFO is empty again.
+ *
+ * The race between arming and a concurrent push is closed on the consumer side: after
+ * arming it must check the FIFO once more, since a producer may have pushed just before
+ * the arm became visible and therefore not rung.  SFIFO_DoorbellArm does both.
+ *
+ * DECLARE_SIMPLE_FIFO(Msg_t, cmd, 256)
+ * SFIFO(cmd) cmdfifo;
+ * DOORBELL_t bell;
+ *
+ * DOORBELL_Init(&bell);                                  // starts armed
+ * epoll_ctl(ep, EPOLL_CTL_ADD, DOORBELL_Fd(&bell), &ev);  // EPOLLIN
+ *
+ * Producer:
+ *     SFIFO_PushRing(cmd, &cmdfifo, msg, &bell);
+ *
+ * Consumer, when epoll reports the doorbell readable:
+ *     DOORBELL_Ack(&bell);
+ *     do {
+ *         while (!SFIFO_IsEmpty(cmd, &cmdfifo))
+ *             handle(SFIFO_Pop(cmd, &cmdfifo));
+ *     } while (!SFIFO_DoorbellArm(cmd, &cmdfifo, &bell));
+ *
+ * A consumer that wants to yield to other descriptors between batches may return to
+ * epoll_wait without arming; it must then poll the FIFO itself (e.g. with a zero
+ * timeout) since nobody will ring.
+ *
+ * Several producers may share a doorbell (e.g. with an MPSC FIFO); the disarm is atomic,
+ * so exactly one of them rings.  Linux only; needs the GCC/clang __atomic builtins.
+ */
+
+#include <stddef.h>
+
+#include "simple_fifo.h"
+
+typedef struct {
+	int    fd;
+	int    armed;
+	size_t rings;      /* number of eventfd writes, i.e. wakeups actually sent */
+} DOORBELL_t;
+
+int  DOORBELL_Init(DOORBELL_t *db);
+void DOORBELL_Close(DOORBELL_t *db);
+void DOORBELL_Signal(DOORBELL_t *db);
+void DOORBELL_Ack(DOORBELL_t *db);
+
+#define DOORBELL_Fd(db) ((db)->fd)
+
+/* Producer side, after publishing data: wake the consumer if it is waiting */
+static inline void DOORBELL_Ring(DOORBELL_t *db)
+{
+	/* Orders the preceding publish before the load of armed (pairs with DOORBELL_Arm) */
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+	/* Plain load first so the common case doesn't bounce the cache line */
+	if (__atomic_load_n(&db->armed, __ATOMIC_RELAXED) &&
+	    __atomic_exchange_n(&db->armed, 0, __ATOMIC_ACQ_REL))
+		DOORBELL_Signal(db);
+}
+
+/* Consumer side: request a ring; the FIFO must be checked again afterwards */
+static inline void DOORBELL_Arm(DOORBELL_t *db)
+{
+	__atomic_store_n(&db->armed, 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+#define SFIFO_PushRing(name, fifo, data, db) \
+	do { \
+		SFIFO_Push(name, fifo, data); \
+		DOORBELL_Ring(db); \
+	} while (0)
+
+/*
+ * Arms the doorbell and re-checks the FIFO.  Returns 1 if it is still empty, so the
+ * consumer may go back to epoll_wait, or 0 if data arrived and it should keep draining.
+ */
+#define SFIFO_DoorbellArm(name, fifo, db) \
+	(DOORBELL_Arm(db), SFIFO_IsEmpty(name, fifo))
+
+#endif // DOORBELL_H_
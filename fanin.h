@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2015 Jason Schmidlapp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef FANIN_H_
+#define FANIN_H_
+
+/*
+ * Many producers, one consumer, without a shared tail.  Each producer gets its own
+ * simple FIFO, so producers never contend with each other, and the consumer polls all of
+ * them.  A bitmap with one bit per producer marks the FIFOs that may have data, so the
+ * consumer only visits those: a poll costs one atomic exchange per 64 producers plus
+ * the work on FIFOs that actually have something.
+ *
+ * Ordering is per producer: entries from one producer come out in the order it pushed
+ * them; entries from different producers are interleaved.  The consumer takes at most
+ * FANIN_BATCH entries from a FIFO per visit, so a busy producer can't starve the others.
+ *
+ * DECLARE_FANIN(Request_t, req, 16, 1024)       // 16 producers, 1024 entries each
+ * FANIN(req) requests;
+ *
+ * FANIN_Init(req, &requests);
+ * FANIN_Push(req, &requests, producerId, r);   // producer producerId only; 0, -EAGAIN
+ *                                               // if full, -EINVAL if producerId >= 16
+ * n = FANIN_Poll(req, &requests, out, max);    // consumer; number of entries copied
+ *
+ * Bitmap protocol: the consumer clears a word of the bitmap before draining the FIFOs it
+ * marked, and sets a bit again for any FIFO it leaves non-empty.  A producer publishes
+ * its entry, then sets its bit if it finds it clear.  There is a full fence on both
+ * sides, as in doorbell.h: the producer's between its publish and its load of the bit,
+ * the consumer's between its exchange and its loads of produce_count (the exchange on
+ * its own does not order those later loads).  Either the consumer's drain sees the entry
+ * or the producer sees the cleared bit, so nothing is left unmarked.  When the bit is
+ * already set the push costs no atomic read-modify-write.
+ *
+ * The size restrictions of simple_fifo.h apply.  Needs the GCC/clang __atomic builtins.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <errno.h>
+
+#include "simple_fifo.h"
+
+#if !defined(__GNUC__)
+#error "fanin.h requires the __atomic builtins"
+#endif
+
+#ifndef FANIN_BATCH
+#define FANIN_BATCH 32
+#endif
+
+#ifndef FANIN_CACHE_LINE
+#define FANIN_CACHE_LINE 64
+#endif
+
+#define FANIN_WORDS(numProducers) (((numProducers) + 63) / 64)
+
+#define FANIN_Init(name, fanin)                     FANIN_Init_##name##_(fanin)
+#define FANIN_Push(name, fanin, producer, data)     FANIN_Push_##name##_(fanin, producer, data)
+#define FANIN_Poll(name, fanin, out, max)           FANIN_Poll_##name##_(fanin, out, max)
+
+#define FANIN(name) FANIN_##name##_t
+
+#define DECLARE_FANIN(type, name, numProducers, size)                            \
+DECLARE_SIMPLE_FIFO(type, FANIN_##name, size)                                    \
+                                                                                 \
+typedef struct {                                                                 \
+	SFIFO(FANIN_##name) fifo;                                                    \
+} __attribute__((aligned(FANIN_CACHE_LINE))) FANIN_##name##_ring_t;              \
+                                                                                 \
+typedef struct {                                                                 \
+	uint64_t ready[FANIN_WORDS(numProducers)];                                   \
+	unsigned nextWord;                                                           \
+	FANIN_##name##_ring_t rings[numProducers];                                   \
+} FANIN_##name##_t;                                                              \
+                                                                                 \
+static inline int FANIN_Init_##name##_(FANIN_##name##_t *fanin)                  \
+{                                                                                \
+	size_t i;                                                                    \
+	if (fanin == NULL)                                                           \
+		return -EINVAL;                                                          \
+	for (i=0; i<FANIN_WORDS(numProducers); i++)                                  \
+		fanin->ready[i] = 0;                                                     \
+	fanin->nextWord = 0;                                                         \
+	for (i=0; i<(numProducers); i++)                                             \
+		SFIFO_Init(FANIN_##name, &fanin->rings[i].fifo);                         \
+	return 0;                                                                    \
+}                                                                                \
+                                                                                 \
+static inline int FANIN_Push_##name##_(FANIN_##name##_t *fanin, unsigned producer, type data) \
+{                                                                                \
+	uint64_t *word, bit;                                                         \
+	if (producer >= (numProducers))                                              \
+		return -EINVAL;                                                          \
+	if (SFIFO_IsFull(FANIN_##name, &fanin->rings[producer].fifo))                \
+		return -EAGAIN;                                                          \
+	SFIFO_Push(FANIN_##name, &fanin->rings[producer].fifo, data);                \
+	word = &fanin->ready[producer / 64];                                         \
+	bit = (uint64_t) 1 << (producer % 64);                                       \
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);                                     \
+	if (!(__atomic_load_n(word, __ATOMIC_RELAXED) & bit))                        \
+		__atomic_fetch_or(word, bit, __ATOMIC_RELAXED);                          \
+	return 0;                                                                    \
+}                                                                                \
+                                                                                 \
+static inline size_t FANIN_Poll_##name##_(FANIN_##name##_t *fanin, type *out, size_t max) \
+{                                                                                \
+	size_t count = 0;                                                            \
+	unsigned w = fanin->nextWord, n;                                             \
+	/* Start at a different word each time so later producers aren't starved */ \
+	for (n=0; (n<FANIN_WORDS(numProducers)) && (count<max); n++) {               \
+		uint64_t pending = 0, again = 0;                                         \
+		if (__atomic_load_n(&fanin->ready[w], __ATOMIC_RELAXED) != 0) {          \
+			pending = __atomic_exchange_n(&fanin->ready[w], 0, __ATOMIC_SEQ_CST); \
+			/* Orders the clear before the loads of produce_count below */       \
+			__atomic_thread_fence(__ATOMIC_SEQ_CST);                             \
+		}                                                                        \
+		while (pending) {                                                        \
+			unsigned bitIndex = __builtin_ctzll(pending);                        \
+			SFIFO(FANIN_##name) *fifo = &fanin->rings[w * 64 + bitIndex].fifo;   \
+			size_t avail, take, i;                                               \
+			if (count == max) {                                                  \
+				/* Out of room: hand the unvisited bits back */                  \
+				again |= pending;                                                \
+				break;                                                           \
+			}                                                                    \
+			pending &= pending - 1;                                              \
+			avail = SFIFO_Size(FANIN_##name, fifo);                              \
+			take = avail;                                                        \
+			if (take > FANIN_BATCH)                                              \
+				take = FANIN_BATCH;                                              \
+			if (take > max - count)                                              \
+				take = max - count;                                              \
+			for (i=0; i<take; i++)                                               \
+				out[count++] = SFIFO_GetAt(FANIN_##name, fifo, i);               \
+			SFIFO_PopN(FANIN_##name, fifo, take);                                \
+			if (avail > take)                                                    \
+				again |= (uint64_t) 1 << bitIndex;                               \
+		}                                                                        \
+		if (again)                                                               \
+			__atomic_fetch_or(&fanin->ready[w], again, __ATOMIC_RELAXED);        \
+		w = (w + 1 == FANIN_WORDS(numProducers)) ? 0 : w + 1;                    \
+	}                                                                            \
+	fanin->nextWord = w;                                                         \
+	return count;                                                                \
+}
+
+#endif // FANIN_H_
@@ -47,6 +47,7 @@ int _FIFO_Init(FIFO_Generic_t *fifo, size_t numEntries)
 	fifo->writeIndex = 0;
 	fifo->readIndex = 0;
 	fifo->count = 0;
+	fifo->dropped = 0;
 
 	return 0;
 }
@@ -54,6 +55,7 @@ int _FIFO_Init(FIFO_Generic_t *fifo, size_t numEntries)
 void _FIFO_Pop(FIFO_Generic_t *fifo, size_t numEntries)
 {
 	fifo->readIndex = (fifo->readIndex + numEntries) % fifo->numDataElems;
+	fifo->count -= numEntries;
 }
 
 size_t _FIFO_Size(FIFO_Generic_t *fifo)
@@ -65,3 +67,8 @@ size_t _FIFO_Space(FIFO_Generic_t *fifo)
 {
 	return (fifo->numDataElems - fifo->count);
 }
+
+size_t _FIFO_Dropped(FIFO_Generic_t *fifo)
+{
+	return fifo->dropped;
+}
@@ -24,13 +24,17 @@
 #define LIFO_H_
 
 #include <stdint.h>
+#include <string.h>
 #include <errno.h>
 
+#include "fifo_stats.h"
+
 typedef struct {
 	size_t numDataElems;
 	size_t readIndex;
 	size_t writeIndex;
 	size_t count;
+	size_t dropped;
 } FIFO_Generic_t;
 
 int    _FIFO_Init(FIFO_Generic_t *fifo, size_t numEntries);
@@ -39,8 +43,7 @@ int    _FIFO_IsFull(FIFO_Generic_t *fifo);
 size_t _FIFO_Size(FIFO_Generic_t *fifo);
 void   _FIFO_Pop(FIFO_Generic_t *fifo, size_t numEntries);
 size_t _FIFO_Space(FIFO_Generic_t *fifo);
-
-// TODO: Why isn't the FIFO memory just part of the structure (like mempool?)
+size_t _FIFO_Dropped(FIFO_Generic_t *fifo);
 
 #define FIFO_IsFull(name, fifo)       FIFO_IsFull_##name##_(fifo)
 #define FIFO_IsEmpty(name, fifo)      FIFO_IsEmpty_##name##_(fifo)
@@ -48,10 +51,17 @@ size_t _FIFO_Space(FIFO_Generic_t *fifo);
 #define FIFO_Space(name, fifo)        FIFO_Space_##name##_(fifo)
 #define FIFO_Pop(name, fifo, numEntries) FIFO_Pop_##name##_(fifo, numEntries)
 #define FIFO_Write(name, fifo, data)  FIFO_Write_##name##_(fifo, data)
+#define FIFO_WriteOverwrite(name, fifo, data) FIFO_WriteOverwrite_##name##_(fifo, data)
+#define FIFO_Dropped(name, fifo)      FIFO_Dropped_##name##_(fifo)
+#define FIFO_StatsSnapshot(name, fifo, stats)    FIFO_StatsSnapshot_##name##_(fifo, stats)
+#define FIFO_StatsAttach(name, fifo, stampBuffer) FIFO_StatsAttach_##name##_(fifo, stampBuffer)
 #define FIFO_Read(name, fifo)         FIFO_Read_##name##_(fifo)
 #define FIFO_Remove(name, fifo, num)  FIFO_Remove_##name##_(fifo, num)
 #define FIFO_Init(name, fifo, numEntries, workingBuffer) FIFO_Init_##name##_(fifo, numEntries, workingBuffer)
 #define FIFO_GetPointer(name, fifo, pptr, plen)          FIFO_GetPointer_##name##_(fifo, pptr, plen)
+#define FIFO_WriteBulk(name, fifo, data, num) FIFO_WriteBulk_##name##_(fifo, data, num)
+#define FIFO_ReadBulk(name, fifo, data, num)  FIFO_ReadBulk_##name##_(fifo, data, num)
+#define FIFO_InitStatic(name, fifo)   FIFO_InitStatic_##name##_(fifo)
 
 #define DECLARE_FIFO(type, name)                                                                                        \
 typedef struct {                                                                                                        \
@@ -59,13 +69,17 @@ typedef struct {
 	size_t readIndex;                                                                                                   \
 	size_t writeIndex;                                                                                                  \
 	size_t count;                                                                                                       \
+	size_t dropped;                                                                                                     \
 	type *queue;                                                                                                        \
+	FIFO_STATS_FIELDS                                                                                                   \
+	FIFO_STATS_STAMP_PTR_FIELD                                                                                          \
 } FIFO_##name##_t;                                                                                                      \
                                                                                                                         \
 static inline int FIFO_IsFull_##name##_(FIFO_##name##_t * fifo)  { return _FIFO_IsFull((FIFO_Generic_t *) fifo);  }     \
 static inline int FIFO_IsEmpty_##name##_(FIFO_##name##_t *fifo)  { return _FIFO_IsEmpty((FIFO_Generic_t *) fifo); }     \
 static inline size_t FIFO_Size_##name##_(FIFO_##name##_t *fifo)  { return _FIFO_Size((FIFO_Generic_t *) fifo);    }     \
 static inline size_t FIFO_Space_##name##_(FIFO_##name##_t *fifo) { return _FIFO_Space((FIFO_Generic_t *) fifo);   }     \
+static inline size_t FIFO_Dropped_##name##_(FIFO_##name##_t *fifo) { return _FIFO_Dropped((FIFO_Generic_t *) fifo); }   \
                                                                                                                         \
 static inline void FIFO_Pop_##name##_(FIFO_##name##_t *fifo, size_t numEntries)                                         \
 {                                                                                                                       \
@@ -78,21 +92,52 @@ static inline int FIFO_Init_##name##_(FIFO_##name##_t *fifo, size_t numEntries,
 		return -EINVAL;                                                                                                 \
                                                                                                                         \
 	fifo->queue = workingBuffer;                                                                                        \
+	FIFO_STATS_RESET(&fifo->stats);                                                                                     \
+	(void) FIFO_STATS_STAMP_ATTACH(fifo, NULL);                                                                         \
 	return _FIFO_Init((FIFO_Generic_t *) fifo, numEntries);                                                             \
+}                                                                                                                       \
+                                                                                                                        \
+static inline int FIFO_StatsSnapshot_##name##_(FIFO_##name##_t *fifo, FIFO_Stats_t *stats)                              \
+{                                                                                                                       \
+	return FIFO_STATS_SNAPSHOT(fifo, stats);                                                                            \
+}                                                                                                                       \
+                                                                                                                        \
+/* stampBuffer must hold as many entries as the FIFO */                                                                 \
+static inline int FIFO_StatsAttach_##name##_(FIFO_##name##_t *fifo, uint64_t *stampBuffer)                              \
+{                                                                                                                       \
+	return FIFO_STATS_STAMP_ATTACH(fifo, stampBuffer);                                                                  \
 }                                                                                                                       \
 																														\
+/* The caller must check FIFO_IsFull first; writing to a full FIFO corrupts it */                                       \
 static inline void FIFO_Write_##name##_(FIFO_##name##_t *fifo, type data)                                               \
 {                                                                                                                       \
 	fifo->queue[fifo->writeIndex] = data;                                                                               \
+	FIFO_STATS_STAMP_PTR(fifo->stamps, fifo->writeIndex);                                                               \
 	fifo->writeIndex = (fifo->writeIndex + 1) % fifo->numDataElems;                                                     \
 	fifo->count++; 																										\
+	FIFO_STATS_ENQUEUE(&fifo->stats, fifo->count, fifo->numDataElems);                                                  \
 }                                                                                                                       \
 																														\
+/* Like FIFO_Write, but when the FIFO is full the oldest entry is discarded (and counted                                \
+ * in FIFO_Dropped) to make room, so the writer never has to check FIFO_IsFull.                                         \
+ */                                                                                                                     \
+static inline void FIFO_WriteOverwrite_##name##_(FIFO_##name##_t *fifo, type data)                                      \
+{                                                                                                                       \
+	if (fifo->count >= fifo->numDataElems) {                                                                            \
+		fifo->readIndex = (fifo->readIndex + 1) % fifo->numDataElems;                                                   \
+		fifo->count--;                                                                                                  \
+		fifo->dropped++;                                                                                                \
+	}                                                                                                                   \
+	FIFO_Write_##name##_(fifo, data);                                                                                   \
+}                                                                                                                       \
+                                                                                                                        \
 static inline type FIFO_Read_##name##_(FIFO_##name##_t *fifo)                                                           \
 {                                                                                                                       \
 	type val = fifo->queue[fifo->readIndex];                                                                            \
+	FIFO_STATS_ADD_LATENCY_PTR(&fifo->stats, fifo->stamps, fifo->readIndex);                                            \
 	fifo->readIndex = (fifo->readIndex + 1) % fifo->numDataElems;                                                       \
 	fifo->count--;                                                                                                      \
+	FIFO_STATS_DEQUEUE(&fifo->stats, fifo->count);                                                                      \
 	return val;                                                                                                         \
 }                                                                                                                       \
 																														\
@@ -100,16 +145,235 @@ static inline void FIFO_GetPointer_##name##_(FIFO_##name##_t *fifo, type **ptr,
 {                                                                                                                       \
 	*ptr = &(fifo->queue[fifo->readIndex]);                                                                             \
                                                                                                                         \
-	if (fifo->writeIndex >= fifo->readIndex)                                                                             \
-		*len = fifo->writeIndex - fifo->readIndex;                                                                      \
+	if (fifo->readIndex + fifo->count <= fifo->numDataElems)                                                            \
+		*len = fifo->count;                                                                                             \
 	else                                                                                                                \
 		*len = fifo->numDataElems - fifo->readIndex;                                                                    \
 }                                                                                                                       \
 																														\
+/* Discards numEntries entries, updating the stats as FIFO_Read/FIFO_ReadBulk would */                                  \
+static inline void FIFO_Remove_##name##_(FIFO_##name##_t *fifo, size_t numEntries)                                      \
+{                                                                                                                       \
+	size_t i;                                                                                                           \
+                                                                                                                        \
+	if (numEntries == 0)                                                                                                \
+		return;                                                                                                         \
+                                                                                                                        \
+	for (i=0; i<numEntries; i++)                                                                                        \
+		FIFO_STATS_ADD_LATENCY_PTR(&fifo->stats, fifo->stamps, (fifo->readIndex + i) % fifo->numDataElems);             \
+	_FIFO_Pop((FIFO_Generic_t *) fifo, numEntries);                                                                     \
+	FIFO_STATS_DEQUEUE(&fifo->stats, fifo->count);                                                                      \
+}                                                                                                                       \
+                                                                                                                        \
+/* Copies up to num entries in (at most two memcpys), returns the number written */                                     \
+static inline size_t FIFO_WriteBulk_##name##_(FIFO_##name##_t *fifo, const type *data, size_t num)                      \
+{                                                                                                                       \
+	size_t i, first;                                                                                                    \
+                                                                                                                        \
+	if (num > fifo->numDataElems - fifo->count)                                                                         \
+		num = fifo->numDataElems - fifo->count;                                                                         \
+	if (num == 0)                                                                                                       \
+		return 0;                                                                                                       \
+	first = fifo->numDataElems - fifo->writeIndex;                                                                      \
+	if (first > num)                                                                                                    \
+		first = num;                                                                                                    \
+                                                                                                                        \
+	memcpy(&fifo->queue[fifo->writeIndex], data, first * sizeof(type));                                                 \
+	memcpy(&fifo->queue[0], data + first, (num - first) * sizeof(type));                                                \
+	for (i=0; i<num; i++)                                                                                               \
+		FIFO_STATS_STAMP_PTR(fifo->stamps, (fifo->writeIndex + i) % fifo->numDataElems);                                \
+                                                                                                                        \
+	fifo->writeIndex = (fifo->writeIndex + num) % fifo->numDataElems;                                                   \
+	fifo->count += num;                                                                                                 \
+	FIFO_STATS_ENQUEUE(&fifo->stats, fifo->count, fifo->numDataElems);                                                  \
+	return num;                                                                                                         \
+}                                                                                                                       \
+                                                                                                                        \
+/* Copies up to num entries out (at most two memcpys), returns the number read */                                       \
+static inline size_t FIFO_ReadBulk_##name##_(FIFO_##name##_t *fifo, type *data, size_t num)                             \
+{                                                                                                                       \
+	size_t i, first;                                                                                                    \
+                                                                                                                        \
+	if (num > fifo->count)                                                                                              \
+		num = fifo->count;                                                                                              \
+	if (num == 0)                                                                                                       \
+		return 0;                                                                                                       \
+	first = fifo->numDataElems - fifo->readIndex;                                                                       \
+	if (first > num)                                                                                                    \
+		first = num;                                                                                                    \
+                                                                                                                        \
+	memcpy(data, &fifo->queue[fifo->readIndex], first * sizeof(type));                                                  \
+	memcpy(data + first, &fifo->queue[0], (num - first) * sizeof(type));                                                \
+	for (i=0; i<num; i++)                                                                                               \
+		FIFO_STATS_ADD_LATENCY_PTR(&fifo->stats, fifo->stamps, (fifo->readIndex + i) % fifo->numDataElems);             \
+                                                                                                                        \
+	fifo->readIndex = (fifo->readIndex + num) % fifo->numDataElems;                                                     \
+	fifo->count -= num;                                                                                                 \
+	FIFO_STATS_DEQUEUE(&fifo->stats, fifo->count);                                                                      \
+	return num;                                                                                                         \
+}
+
+/*
+ * Same API as DECLARE_FIFO, but the storage is part of the structure and the capacity
+ * is a compile time constant, so there is no pointer to chase and the index wrap folds
+ * into a compare against a constant.  Initialize with FIFO_InitStatic(name, fifo)
+ * instead of FIFO_Init; FIFO_StatsAttach is not needed (timestamps are in the structure).
+ *
+ * The leading fields match FIFO_Generic_t, so code written against the generic
+ * functions works on either kind of FIFO.
+ *
+ * DECLARE_STATIC_FIFO(uint8_t, uart, 256)
+ * FIFO(uart) rxfifo;
+ *
+ * FIFO_InitStatic(uart, &rxfifo);
+ * FIFO_Write(uart, &rxfifo, byte);
+ */
+#define DECLARE_STATIC_FIFO(type, name, size)                                                                           \
+typedef struct {                                                                                                        \
+	size_t numDataElems;                                                                                                \
+	size_t readIndex;                                                                                                   \
+	size_t writeIndex;                                                                                                  \
+	size_t count;                                                                                                       \
+	size_t dropped;                                                                                                     \
+	type queue[size];                                                                                                   \
+	FIFO_STATS_FIELDS                                                                                                   \
+	FIFO_STATS_STAMP_FIELDS(size)                                                                                       \
+} FIFO_##name##_t;                                                                                                      \
+                                                                                                                        \
+static inline int FIFO_IsFull_##name##_(FIFO_##name##_t *fifo)    { return (fifo->count == (size)); }                   \
+static inline int FIFO_IsEmpty_##name##_(FIFO_##name##_t *fifo)   { return (fifo->count == 0); }                        \
+static inline size_t FIFO_Size_##name##_(FIFO_##name##_t *fifo)   { return fifo->count; }                               \
+static inline size_t FIFO_Space_##name##_(FIFO_##name##_t *fifo)  { return (size) - fifo->count; }                      \
+static inline size_t FIFO_Dropped_##name##_(FIFO_##name##_t *fifo) { return fifo->dropped; }                            \
+                                                                                                                        \
+static inline size_t FIFO_Wrap_##name##_(size_t index)                                                                  \
+{                                                                                                                       \
+	return (index >= (size)) ? index - (size) : index;                                                                  \
+}                                                                                                                       \
+                                                                                                                        \
+static inline int FIFO_InitStatic_##name##_(FIFO_##name##_t *fifo)                                                      \
+{                                                                                                                       \
+	if (fifo == NULL)                                                                                                   \
+		return -EINVAL;                                                                                                 \
+                                                                                                                        \
+	fifo->numDataElems = (size);                                                                                        \
+	fifo->readIndex = 0;                                                                                                \
+	fifo->writeIndex = 0;                                                                                               \
+	fifo->count = 0;                                                                                                    \
+	fifo->dropped = 0;                                                                                                  \
+	FIFO_STATS_RESET(&fifo->stats);                                                                                     \
+	return 0;                                                                                                           \
+}                                                                                                                       \
+                                                                                                                        \
+static inline int FIFO_StatsSnapshot_##name##_(FIFO_##name##_t *fifo, FIFO_Stats_t *stats)                              \
+{                                                                                                                       \
+	return FIFO_STATS_SNAPSHOT(fifo, stats);                                                                            \
+}                                                                                                                       \
+                                                                                                                        \
+static inline void FIFO_Pop_##name##_(FIFO_##name##_t *fifo, size_t numEntries)                                         \
+{                                                                                                                       \
+	fifo->readIndex = FIFO_Wrap_##name##_(fifo->readIndex + numEntries);                                                \
+	fifo->count -= numEntries;                                                                                          \
+}                                                                                                                       \
+                                                                                                                        \
+/* The caller must check FIFO_IsFull first; writing to a full FIFO corrupts it */                                       \
+static inline void FIFO_Write_##name##_(FIFO_##name##_t *fifo, type data)                                               \
+{                                                                                                                       \
+	fifo->queue[fifo->writeIndex] = data;                                                                               \
+	FIFO_STATS_STAMP(fifo->stamps, fifo->writeIndex);                                                                   \
+	fifo->writeIndex = FIFO_Wrap_##name##_(fifo->writeIndex + 1);                                                       \
+	fifo->count++;                                                                                                      \
+	FIFO_STATS_ENQUEUE(&fifo->stats, fifo->count, (size));                                                              \
+}                                                                                                                       \
+                                                                                                                        \
+static inline void FIFO_WriteOverwrite_##name##_(FIFO_##name##_t *fifo, type data)                                      \
+{                                                                                                                       \
+	if (fifo->count == (size)) {                                                                                        \
+		fifo->readIndex = FIFO_Wrap_##name##_(fifo->readIndex + 1);                                                     \
+		fifo->count--;                                                                                                  \
+		fifo->dropped++;                                                                                                \
+	}                                                                                                                   \
+	FIFO_Write_##name##_(fifo, data);                                                                                   \
+}                                                                                                                       \
+                                                                                                                        \
+static inline type FIFO_Read_##name##_(FIFO_##name##_t *fifo)                                                           \
+{                                                                                                                       \
+	type val = fifo->queue[fifo->readIndex];                                                                            \
+	FIFO_STATS_ADD_LATENCY(&fifo->stats, fifo->stamps, fifo->readIndex);                                                \
+	fifo->readIndex = FIFO_Wrap_##name##_(fifo->readIndex + 1);                                                         \
+	fifo->count--;                                                                                                      \
+	FIFO_STATS_DEQUEUE(&fifo->stats, fifo->count);                                                                      \
+	return val;                                                                                                         \
+}                                                                                                                       \
+                                                                                                                        \
+static inline void FIFO_GetPointer_##name##_(FIFO_##name##_t *fifo, type **ptr, size_t *len)                            \
+{                                                                                                                       \
+	*ptr = &(fifo->queue[fifo->readIndex]);                                                                             \
+                                                                                                                        \
+	if (fifo->readIndex + fifo->count <= (size))                                                                        \
+		*len = fifo->count;                                                                                             \
+	else                                                                                                                \
+		*len = (size) - fifo->readIndex;                                                                                \
+}                                                                                                                       \
+                                                                                                                        \
+/* Discards numEntries entries, updating the stats as FIFO_Read/FIFO_ReadBulk would */                                  \
 static inline void FIFO_Remove_##name##_(FIFO_##name##_t *fifo, size_t numEntries)                                      \
 {                                                                                                                       \
-	while (numEntries--)                                                                                                \
-		FIFO_Read_##name##_(fifo);                                                                                      \
+	size_t i;                                                                                                           \
+                                                                                                                        \
+	if (numEntries == 0)                                                                                                \
+		return;                                                                                                         \
+                                                                                                                        \
+	for (i=0; i<numEntries; i++)                                                                                        \
+		FIFO_STATS_ADD_LATENCY(&fifo->stats, fifo->stamps, FIFO_Wrap_##name##_(fifo->readIndex + i));                   \
+	FIFO_Pop_##name##_(fifo, numEntries);                                                                               \
+	FIFO_STATS_DEQUEUE(&fifo->stats, fifo->count);                                                                      \
+}                                                                                                                       \
+                                                                                                                        \
+static inline size_t FIFO_WriteBulk_##name##_(FIFO_##name##_t *fifo, const type *data, size_t num)                      \
+{                                                                                                                       \
+	size_t i, first;                                                                                                    \
+                                                                                                                        \
+	if (num > (size) - fifo->count)                                                                                     \
+		num = (size) - fifo->count;                                                                                     \
+	if (num == 0)                                                                                                       \
+		return 0;                                                                                                       \
+	first = (size) - fifo->writeIndex;                                                                                  \
+	if (first > num)                                                                                                    \
+		first = num;                                                                                                    \
+                                                                                                                        \
+	memcpy(&fifo->queue[fifo->writeIndex], data, first * sizeof(type));                                                 \
+	memcpy(&fifo->queue[0], data + first, (num - first) * sizeof(type));                                                \
+	for (i=0; i<num; i++)                                                                                               \
+		FIFO_STATS_STAMP(fifo->stamps, FIFO_Wrap_##name##_(fifo->writeIndex + i));                                      \
+                                                                                                                        \
+	fifo->writeIndex = FIFO_Wrap_##name##_(fifo->writeIndex + num);                                                     \
+	fifo->count += num;                                                                                                 \
+	FIFO_STATS_ENQUEUE(&fifo->stats, fifo->count, (size));                                                              \
+	return num;                                                                                                         \
+}                                                                                                                       \
+                                                                                                                        \
+static inline size_t FIFO_ReadBulk_##name##_(FIFO_##name##_t *fifo, type *data, size_t num)                             \
+{                                                                                                                       \
+	size_t i, first;                                                                                                    \
+                                                                                                                        \
+	if (num > fifo->count)                                                                                              \
+		num = fifo->count;                                                                                              \
+	if (num == 0)                                                                                                       \
+		return 0;                                                                                                       \
+	first = (size) - fifo->readIndex;                                                                                   \
+	if (first > num)                                                                                                    \
+		first = num;                                                                                                    \
+                                                                                                                        \
+	memcpy(data, &fifo->queue[fifo->readIndex], first * sizeof(type));                                                  \
+	memcpy(data + first, &fifo->queue[0], (num - first) * sizeof(type));                                                \
+	for (i=0; i<num; i++)                                                                                               \
+		FIFO_STATS_ADD_LATENCY(&fifo->stats, fifo->stamps, FIFO_Wrap_##name##_(fifo->readIndex + i));                   \
+                                                                                                                        \
+	fifo->readIndex = FIFO_Wrap_##name##_(fifo->readIndex + num);                                                       \
+	fifo->count -= num;                                                                                                 \
+	FIFO_STATS_DEQUEUE(&fifo->stats, fifo->count);                                                                      \
+	return num;                                                                                                         \
 }
 
 #define FIFO(name) FIFO_##name##_t
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2015 Jason Schmidlapp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <errno.h>
+#include <sys/uio.h>
+
+#include "fifo_io.h"
+
+/* Describes len bytes of a ring of cap bytes starting at index start */
+static int FIFO_Spans(uint8_t *buffer, size_t cap, size_t start, size_t len, struct iovec *iov)
+{
+	size_t first = cap - start;
+
+	if (first >= len) {
+		iov[0].iov_base = buffer + start;
+		iov[0].iov_len = len;
+		return 1;
+	}
+
+	iov[0].iov_base = buffer + start;
+	iov[0].iov_len = first;
+	iov[1].iov_base = buffer;
+	iov[1].iov_len = len - first;
+	return 2;
+}
+
+ssize_t _FIFO_ReadFd(FIFO_Generic_t *fifo, uint8_t *queue, int fd)
+{
+	struct iovec iov[2];
+	size_t space = fifo->numDataElems - fifo->count;
+	ssize_t result;
+
+	if (space == 0)
+		return -ENOBUFS;
+
+	result = readv(fd, iov, FIFO_Spans(queue, fifo->numDataElems, fifo->writeIndex, space, iov));
+	if (result < 0)
+		return -errno;
+
+	fifo->writeIndex = (fifo->writeIndex + result) % fifo->numDataElems;
+	fifo->count += result;
+
+	return result;
+}
+
+ssize_t _FIFO_WriteFd(FIFO_Generic_t *fifo, uint8_t *queue, int fd)
+{
+	struct iovec iov[2];
+	ssize_t result;
+
+	if (fifo->count == 0)
+		return 0;
+
+	result = writev(fd, iov, FIFO_Spans(queue, fifo->numDataElems, fifo->readIndex, fifo->count, iov));
+	if (result < 0)
+		return -errno;
+
+	fifo->readIndex = (fifo->readIndex + result) % fifo->numDataElems;
+	fifo->count -= result;
+
+	return result;
+}
+
+ssize_t _SFIFO_ReadFd(size_t *produceCount, size_t *consumeCount, uint8_t *buffer, size_t size, int fd)
+{
+	struct iovec iov[2];
+	size_t produced = *produceCount;
+	size_t space = size - (produced - SFIFO_LOAD_ACQUIRE(consumeCount));
+	ssize_t result;
+
+	if (space == 0)
+		return -ENOBUFS;
+
+	result = readv(fd, iov, FIFO_Spans(buffer, size, MOD2(produced, size), space, iov));
+	if (result < 0)
+		return -errno;
+
+	return result;
+}
+
+ssize_t _SFIFO_WriteFd(size_t *produceCount, size_t *consumeCount, uint8_t *buffer, size_t size, int fd)
+{
+	struct iovec iov[2];
+	size_t consumed = *consumeCount;
+	size_t avail = SFIFO_LOAD_ACQUIRE(produceCount) - consumed;
+	ssize_t result;
+
+	if (avail == 0)
+		return 0;
+
+	result = writev(fd, iov, FIFO_Spans(buffer, size, MOD2(consumed, size), avail, iov));
+	if (result < 0)
+		return -errno;
+
+	SFIFO_STORE_RELEASE(consumeCount, consumed + result);
+
+	return result;
+}
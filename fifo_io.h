@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2015 Jason Schmidlapp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef FIFO_IO_H_
+#define FIFO_IO_H_
+
+/*
+ * Scatter-gather I/O between byte FIFOs and file descriptors.  The free (or filled)
+ * part of a ring is at most two contiguous spans, so a single readv (or writev) moves
+ * data straight between the descriptor and the FIFO storage without an intermediate
+ * buffer.  Exactly the number of bytes transferred is committed to the FIFO.
+ *
+ * After declaring a byte FIFO, declare its I/O functions:
+ *
+ * DECLARE_FIFO(uint8_t, sock)              (or DECLARE_STATIC_FIFO(uint8_t, sock, 4096))
+ * DECLARE_FIFO_IO(sock)
+ *
+ * DECLARE_SIMPLE_FIFO(uint8_t, pipe, 4096)
+ * DECLARE_SIMPLE_FIFO_IO(pipe, 4096)
+ *
+ * FIFO_ReadFd(name, fifo, fd)   - fill the FIFO from fd (one readv)
+ * FIFO_WriteFd(name, fifo, fd)  - drain the FIFO to fd (one writev)
+ * SFIFO_ReadFd / SFIFO_WriteFd  - the same for simple FIFOs; ReadFd is a producer side
+ *                                 call and WriteFd a consumer side call
+ *
+ * All return the number of bytes transferred, 0 at end of file (ReadFd) or when there
+ * is nothing to write (WriteFd), -ENOBUFS when ReadFd finds the FIFO full, or -errno
+ * if the system call fails (e.g. -EAGAIN on a non-blocking descriptor).
+ *
+ * With FIFO_STATS, each ReadFd/WriteFd counts as one write/read for the occupancy
+ * statistics, and with FIFO_STATS_LATENCY ReadFd stamps every slot it fills, so entries
+ * read later with FIFO_Read/SFIFO_Pop report their latency from the readv.  WriteFd
+ * does not record latency.
+ */
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "fifo.h"
+#include "simple_fifo.h"
+
+ssize_t _FIFO_ReadFd(FIFO_Generic_t *fifo, uint8_t *queue, int fd);
+ssize_t _FIFO_WriteFd(FIFO_Generic_t *fifo, uint8_t *queue, int fd);
+/* Fills the free space but doesn't publish it; the caller stores produce_count */
+ssize_t _SFIFO_ReadFd(size_t *produceCount, size_t *consumeCount, uint8_t *buffer, size_t size, int fd);
+ssize_t _SFIFO_WriteFd(size_t *produceCount, size_t *consumeCount, uint8_t *buffer, size_t size, int fd);
+
+#define FIFO_ReadFd(name, fifo, fd)   FIFO_ReadFd_##name##_(fifo, fd)
+#define FIFO_WriteFd(name, fifo, fd)  FIFO_WriteFd_##name##_(fifo, fd)
+#define SFIFO_ReadFd(name, fifo, fd)  SFIFO_ReadFd_##name##_(fifo, fd)
+#define SFIFO_WriteFd(name, fifo, fd) SFIFO_WriteFd_##name##_(fifo, fd)
+
+#define DECLARE_FIFO_IO(name)                                                    \
+static inline ssize_t FIFO_ReadFd_##name##_(FIFO_##name##_t *fifo, int fd)       \
+{                                                                                \
+	size_t start = fifo->writeIndex;                                             \
+	ssize_t result = _FIFO_ReadFd((FIFO_Generic_t *) fifo, fifo->queue, fd);     \
+	(void) start;                                                                \
+	if (result > 0) {                                                            \
+		FIFO_STATS_STAMP_RANGE(fifo->stamps, start, result, fifo->numDataElems); \
+		FIFO_STATS_ENQUEUE(&fifo->stats, fifo->count, fifo->numDataElems);       \
+	}                                                                            \
+	return result;                                                               \
+}                                                                                \
+                                                                                 \
+static inline ssize_t FIFO_WriteFd_##name##_(FIFO_##name##_t *fifo, int fd)      \
+{                                                                                \
+	ssize_t result = _FIFO_WriteFd((FIFO_Generic_t *) fifo, fifo->queue, fd);    \
+	if (result > 0)                                                              \
+		FIFO_STATS_DEQUEUE(&fifo->stats, fifo->count);                           \
+	return result;                                                               \
+}
+
+#define DECLARE_SIMPLE_FIFO_IO(name, size)                                       \
+static inline ssize_t SFIFO_ReadFd_##name##_(SFIFO_##name##_t *fifo, int fd)     \
+{                                                                                \
+	size_t start = fifo->produce_count;                                          \
+	ssize_t result = _SFIFO_ReadFd(&fifo->produce_count, &fifo->consume_count,   \
+	                               fifo->buffer, size, fd);                      \
+	if (result > 0) {                                                            \
+		/* Stamp and sample first: once published, the bytes may be consumed */  \
+		FIFO_STATS_STAMP_RANGE(fifo->stamps, MOD2(start, size), result, size);   \
+		FIFO_STATS_ENQUEUE(&fifo->stats,                                         \
+		                   start + result - SFIFO_LOAD_ACQUIRE(&fifo->consume_count), size); \
+		SFIFO_STORE_RELEASE(&fifo->produce_count, start + result);               \
+	}                                                                            \
+	return result;                                                               \
+}                                                                                \
+                                                                                 \
+static inline ssize_t SFIFO_WriteFd_##name##_(SFIFO_##name##_t *fifo, int fd)    \
+{                                                                                \
+	ssize_t result = _SFIFO_WriteFd(&fifo->produce_count, &fifo->consume_count,  \
+	                                fifo->buffer, size, fd);                     \
+	if (result > 0)                                                              \
+		FIFO_STATS_DEQUEUE(&fifo->stats,                                         \
+		                   SFIFO_LOAD_ACQUIRE(&fifo->produce_count) - fifo->consume_count); \
+	return result;                                                               \
+}
+
+#endif // FIFO_IO_H_
@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2015 Jason Schmidlapp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <string.h>
+#include <errno.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FIFO_SCAN_X86
+#endif
+
+#include "fifo_scan.h"
+
+/* Returns the first byte in p[0..len) that is in set, or NULL */
+typedef const uint8_t *(*FIFO_ScanFunc_t)(const uint8_t *p, size_t len, const uint8_t *set, size_t setLen);
+
+static const uint8_t *FIFO_ScanScalar(const uint8_t *p, size_t len, const uint8_t *set, size_t setLen)
+{
+	size_t i, k;
+
+	if (setLen == 1)
+		return memchr(p, set[0], len);
+
+	for (i=0; i<len; i++) {
+		for (k=0; k<setLen; k++) {
+			if (p[i] == set[k])
+				return p + i;
+		}
+	}
+
+	return NULL;
+}
+
+#ifdef FIFO_SCAN_X86
+
+__attribute__((target("sse2")))
+static const uint8_t *FIFO_ScanSSE2(const uint8_t *p, size_t len, const uint8_t *set, size_t setLen)
+{
+	__m128i needles[FIFO_SCAN_MAX_SET];
+	size_t i, k;
+
+	for (k=0; k<setLen; k++)
+		needles[k] = _mm_set1_epi8((char) set[k]);
+
+	for (i=0; i+16<=len; i+=16) {
+		__m128i block = _mm_loadu_si128((const __m128i *) (p + i));
+		__m128i match = _mm_cmpeq_epi8(block, needles[0]);
+		unsigned mask;
+
+		for (k=1; k<setLen; k++)
+			match = _mm_or_si128(match, _mm_cmpeq_epi8(block, needles[k]));
+
+		mask = (unsigned) _mm_movemask_epi8(match);
+		if (mask)
+			return p + i + __builtin_ctz(mask);
+	}
+
+	return FIFO_ScanScalar(p + i, len - i, set, setLen);
+}
+
+__attribute__((target("avx2")))
+static const uint8_t *FIFO_ScanAVX2(const uint8_t *p, size_t len, const uint8_t *set, size_t setLen)
+{
+	__m256i needles[FIFO_SCAN_MAX_SET];
+	size_t i, k;
+
+	for (k=0; k<setLen; k++)
+		needles[k] = _mm256_set1_epi8((char) set[k]);
+
+	for (i=0; i+32<=len; i+=32) {
+		__m256i block = _mm256_loadu_si256((const __m256i *) (p + i));
+		__m256i match = _mm256_cmpeq_epi8(block, needles[0]);
+		unsigned mask;
+
+		for (k=1; k<setLen; k++)
+			match = _mm256_or_si256(match, _mm256_cmpeq_epi8(block, needles[k]));
+
+		mask = (unsigned) _mm256_movemask_epi8(match);
+		if (mask)
+			return p + i + __builtin_ctz(mask);
+	}
+
+	/* The remaining < 32 bytes */
+	return FIFO_ScanSSE2(p + i, len - i, set, setLen);
+}
+
+#endif
+
+static FIFO_ScanFunc_t FIFO_scan;
+
+int FIFO_ScanSelect(FIFO_ScanImpl_t impl)
+{
+	FIFO_ScanFunc_t func = FIFO_ScanScalar;
+
+#ifdef FIFO_SCAN_X86
+	__builtin_cpu_init();
+
+	if (impl == FIFO_SCAN_AUTO)
+		impl = __builtin_cpu_supports("avx2") ? FIFO_SCAN_AVX2 :
+		       __builtin_cpu_supports("sse2") ? FIFO_SCAN_SSE2 : FIFO_SCAN_SCALAR;
+
+	if (impl == FIFO_SCAN_AVX2) {
+		if (!__builtin_cpu_supports("avx2"))
+			return -ENOTSUP;
+		func = FIFO_ScanAVX2;
+	}
+	else if (impl == FIFO_SCAN_SSE2) {
+		if (!__builtin_cpu_supports("sse2"))
+			return -ENOTSUP;
+		func = FIFO_ScanSSE2;
+	}
+#else
+	if ((impl != FIFO_SCAN_AUTO) && (impl != FIFO_SCAN_SCALAR))
+		return -ENOTSUP;
+#endif
+
+	/* A race between two first callers stores the same value */
+	__atomic_store_n(&FIFO_scan, func, __ATOMIC_RELAXED);
+	return 0;
+}
+
+ssize_t _FIFO_FindAny(FIFO_Generic_t *fifo, const uint8_t *queue, size_t from,
+                      const uint8_t *set, size_t setLen)
+{
+	FIFO_ScanFunc_t scan = __atomic_load_n(&FIFO_scan, __ATOMIC_RELAXED);
+	size_t start, first, len;
+	const uint8_t *match;
+
+	if ((set == NULL) || (setLen == 0) || (setLen > FIFO_SCAN_MAX_SET))
+		return -EINVAL;
+
+	if (from >= fifo->count)
+		return -ENOENT;
+
+	if (scan == NULL) {
+		FIFO_ScanSelect(FIFO_SCAN_AUTO);
+		scan = __atomic_load_n(&FIFO_scan, __ATOMIC_RELAXED);
+	}
+
+	/* First span: from the start position up to the end of the data or of the buffer */
+	start = fifo->readIndex + from;
+	if (start >= fifo->numDataElems)
+		start -= fifo->numDataElems;
+
+	len = fifo->count - from;
+	first = fifo->numDataElems - start;
+	if (first > len)
+		first = len;
+
+	match = scan(queue + start, first, set, setLen);
+	if (match)
+		return from + (match - (queue + start));
+
+	/* Second span: the wrapped part at the beginning of the buffer */
+	if (len > first) {
+		match = scan(queue, len - first, set, setLen);
+		if (match)
+			return from + first + (match - queue);
+	}
+
+	return -ENOENT;
+}
+
+int _FIFO_PeekAt(FIFO_Generic_t *fifo, const uint8_t *queue, size_t offset,
+                 uint8_t *data, size_t len)
+{
+	size_t start, first;
+
+	if ((offset > fifo->count) || (len > fifo->count - offset))
+		return -ERANGE;
+
+	start = fifo->readIndex + offset;
+	if (start >= fifo->numDataElems)
+		start -= fifo->numDataElems;
+
+	first = fifo->numDataElems - start;
+	if (first >= len) {
+		memcpy(data, queue + start, len);
+	}
+	else {
+		memcpy(data, queue + start, first);
+		memcpy(data + first, queue, len - first);
+	}
+
+	return 0;
+}
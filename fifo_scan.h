@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2015 Jason Schmidlapp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef FIFO_SCAN_H_
+#define FIFO_SCAN_H_
+
+/*
+ * In-place searching of byte FIFOs, for locating record framing (a newline, a
+ * delimiter, a length field) before reading anything out.  The filled part of a ring is
+ * at most two contiguous spans; the functions below scan both, so callers never have to
+ * deal with the wrap.  Nothing is consumed.
+ *
+ * DECLARE_FIFO(uint8_t, rx)                (or DECLARE_STATIC_FIFO(uint8_t, rx, 4096))
+ * DECLARE_FIFO_SCAN(rx)
+ *
+ * FIFO_FindByte(name, fifo, from, byte)        - offset (from the oldest byte) of the
+ *                                                first byte at or after from
+ * FIFO_FindAny(name, fifo, from, set, setLen)  - the same for any of setLen bytes
+ *                                                (at most FIFO_SCAN_MAX_SET)
+ * FIFO_PeekAt(name, fifo, offset, data, len)   - copy len bytes starting at offset
+ *
+ * The find calls return the offset, or -ENOENT if there is no match (so a caller
+ * waiting for more data can pass the old FIFO size as from next time).  FindAny returns
+ * -EINVAL for a bad set.  PeekAt returns 0, or -ERANGE if the FIFO holds fewer than
+ * offset+len bytes.
+ *
+ * ssize_t end = FIFO_FindByte(rx, &rxfifo, 0, '\n');
+ * if (end >= 0)
+ *     FIFO_ReadBulk(rx, &rxfifo, line, end + 1);
+ *
+ * On x86 the searches use AVX2 or SSE2, chosen at run time; elsewhere a scalar loop.
+ * FIFO_ScanSelect can force a particular implementation (for testing and benchmarks).
+ */
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "fifo.h"
+
+#define FIFO_SCAN_MAX_SET 8
+
+typedef enum {
+	FIFO_SCAN_AUTO,
+	FIFO_SCAN_SCALAR,
+	FIFO_SCAN_SSE2,
+	FIFO_SCAN_AVX2
+} FIFO_ScanImpl_t;
+
+/* Returns 0, or -ENOTSUP if impl isn't available on this machine */
+int FIFO_ScanSelect(FIFO_ScanImpl_t impl);
+
+ssize_t _FIFO_FindAny(FIFO_Generic_t *fifo, const uint8_t *queue, size_t from,
+                      const uint8_t *set, size_t setLen);
+int     _FIFO_PeekAt(FIFO_Generic_t *fifo, const uint8_t *queue, size_t offset,
+                     uint8_t *data, size_t len);
+
+#define FIFO_FindByte(name, fifo, from, byte)       FIFO_FindByte_##name##_(fifo, from, byte)
+#define FIFO_FindAny(name, fifo, from, set, setLen) FIFO_FindAny_##name##_(fifo, from, set, setLen)
+#define FIFO_PeekAt(name, fifo, offset, data, len)  FIFO_PeekAt_##name##_(fifo, offset, data, len)
+
+#define DECLARE_FIFO_SCAN(name)                                                  \
+static inline ssize_t FIFO_FindByte_##name##_(FIFO_##name##_t *fifo, size_t from, uint8_t byte) \
+{                                                                                \
+	return _FIFO_FindAny((FIFO_Generic_t *) fifo, fifo->queue, from, &byte, 1);  \
+}                                                                                \
+                                                                                 \
+static inline ssize_t FIFO_FindAny_##name##_(FIFO_##name##_t *fifo, size_t from, \
+                                             const uint8_t *set, size_t setLen)  \
+{                                                                                \
+	return _FIFO_FindAny((FIFO_Generic_t *) fifo, fifo->queue, from, set, setLen); \
+}                                                                                \
+                                                                                 \
+static inline int FIFO_PeekAt_##name##_(FIFO_##name##_t *fifo, size_t offset,    \
+                                        uint8_t *data, size_t len)               \
+{                                                                                \
+	return _FIFO_PeekAt((FIFO_Generic_t *) fifo, fifo->queue, offset, data, len); \
+}
+
+#endif // FIFO_SCAN_H_
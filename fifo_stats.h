@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2015 Jason Schmidlapp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef FIFO_STATS_H_
+#define FIFO_STATS_H_
+
+/*
+ * Optional instrumentation for DECLARE_FIFO and DECLARE_SIMPLE_FIFO (including the
+ * overwrite variant).  It is compiled in only when FIFO_STATS is defined before
+ * fifo.h/simple_fifo.h are included; otherwise the hooks below expand to nothing and
+ * the FIFO structures are unchanged.  Since the structure layout depends on it,
+ * FIFO_STATS must be defined the same way in every file that shares a given FIFO.
+ *
+ * Collected per FIFO:
+ *
+ * - highWater   : largest occupancy seen
+ * - histogram   : occupancy sampled on every write, in FIFO_STATS_BUCKETS equal
+ *                 slices of the capacity (bucket 0 is the emptiest)
+ * - fullEvents  : writes that left the FIFO full
+ * - emptyEvents : reads that left the FIFO empty
+ *
+ * Defining FIFO_STATS_LATENCY as well stores a timestamp per slot on write and
+ * accumulates the write-to-read delay (in FIFO_STATS_Now() ticks) on read.  Simple FIFOs
+ * hold the timestamps in the structure; DECLARE_FIFO uses external memory, so a buffer of
+ * numEntries uint64_t must be attached with FIFO_StatsAttach after FIFO_Init.
+ *
+ * Read the counters with FIFO_StatsSnapshot/SFIFO_StatsSnapshot, which return -ENOTSUP
+ * (and a zeroed snapshot) when FIFO_STATS is not defined.  For a simple FIFO the producer
+ * and consumer update separate fields; a snapshot taken from a third thread is not
+ * atomic as a whole.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+
+#ifndef FIFO_STATS_BUCKETS
+#define FIFO_STATS_BUCKETS 8
+#endif
+
+typedef struct {
+	size_t   highWater;
+	uint64_t histogram[FIFO_STATS_BUCKETS];
+	uint64_t fullEvents;
+	uint64_t emptyEvents;
+	uint64_t latencyCount;
+	uint64_t latencyTotal;
+	uint64_t latencyMax;
+} FIFO_Stats_t;
+
+/* Timestamp source; may be overridden with a platform specific counter */
+#ifndef FIFO_STATS_Now
+#if defined(__i386__) || defined(__x86_64__)
+#include <x86intrin.h>
+#define FIFO_STATS_Now() ((uint64_t) __rdtsc())
+#elif defined(__aarch64__)
+static inline uint64_t FIFO_STATS_Now(void)
+{
+	uint64_t val;
+	__asm__ volatile("mrs %0, cntvct_el0" : "=r" (val));
+	return val;
+}
+#else
+#include <time.h>
+static inline uint64_t FIFO_STATS_Now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+#endif
+#endif
+
+static inline void _FIFO_StatsEnqueue(FIFO_Stats_t *stats, size_t occupancy, size_t capacity)
+{
+	/* A write always leaves at least one entry; anything else is a racy sample */
+	if (occupancy == 0)
+		return;
+
+	/* An overwriting FIFO may briefly appear to hold more than its capacity */
+	if (occupancy > capacity)
+		occupancy = capacity;
+
+	if (occupancy > stats->highWater)
+		stats->highWater = occupancy;
+
+	stats->histogram[((occupancy - 1) * FIFO_STATS_BUCKETS) / capacity]++;
+
+	if (occupancy >= capacity)
+		stats->fullEvents++;
+}
+
+static inline void _FIFO_StatsDequeue(FIFO_Stats_t *stats, size_t occupancy)
+{
+	if (occupancy == 0)
+		stats->emptyEvents++;
+}
+
+/* Stamp num slots from start, wrapping at capacity; stamps may be NULL (not attached) */
+static inline void _FIFO_StatsStampRange(uint64_t *stamps, size_t start, size_t num, size_t capacity)
+{
+	uint64_t now;
+
+	if (stamps == NULL)
+		return;
+
+	now = FIFO_STATS_Now();
+	while (num--) {
+		stamps[start] = now;
+		if (++start == capacity)
+			start = 0;
+	}
+}
+
+static inline void _FIFO_StatsLatency(FIFO_Stats_t *stats, uint64_t stamp)
+{
+	uint64_t delta = FIFO_STATS_Now() - stamp;
+
+	stats->latencyCount++;
+	stats->latencyTotal += delta;
+	if (delta > stats->latencyMax)
+		stats->latencyMax = delta;
+}
+
+#ifdef FIFO_STATS
+#define FIFO_STATS_FIELDS                       FIFO_Stats_t stats;
+#define FIFO_STATS_RESET(stats)                 memset(stats, 0, sizeof(FIFO_Stats_t))
+#define FIFO_STATS_ENQUEUE(stats, occ, cap)     _FIFO_StatsEnqueue(stats, occ, cap)
+#define FIFO_STATS_DEQUEUE(stats, occ)          _FIFO_StatsDequeue(stats, occ)
+#define FIFO_STATS_SNAPSHOT(fifo, out)          (memcpy(out, &(fifo)->stats, sizeof(FIFO_Stats_t)), 0)
+#else
+#define FIFO_STATS_FIELDS
+#define FIFO_STATS_RESET(stats)                 do { } while (0)
+#define FIFO_STATS_ENQUEUE(stats, occ, cap)     do { } while (0)
+#define FIFO_STATS_DEQUEUE(stats, occ)          do { } while (0)
+/* These take the FIFO rather than its fields, so they can use it without the fields */
+#define FIFO_STATS_SNAPSHOT(fifo, out)          ((void) (fifo), memset(out, 0, sizeof(FIFO_Stats_t)), -ENOTSUP)
+#endif
+
+#if defined(FIFO_STATS) && defined(FIFO_STATS_LATENCY)
+#define FIFO_STATS_STAMP_FIELDS(size)           uint64_t stamps[size];
+#define FIFO_STATS_STAMP_PTR_FIELD              uint64_t *stamps;
+#define FIFO_STATS_STAMP(stamps, slot)          ((stamps)[slot] = FIFO_STATS_Now())
+#define FIFO_STATS_ADD_LATENCY(stats, stamps, slot) _FIFO_StatsLatency(stats, (stamps)[slot])
+#define FIFO_STATS_STAMP_PTR(stamps, slot)      do { if (stamps) FIFO_STATS_STAMP(stamps, slot); } while (0)
+#define FIFO_STATS_ADD_LATENCY_PTR(stats, stamps, slot) \
+	do { if (stamps) FIFO_STATS_ADD_LATENCY(stats, stamps, slot); } while (0)
+#define FIFO_STATS_STAMP_ATTACH(fifo, buffer)   ((fifo)->stamps = (buffer), 0)
+#define FIFO_STATS_STAMP_RANGE(stamps, start, num, cap) _FIFO_StatsStampRange(stamps, start, num, cap)
+#else
+#define FIFO_STATS_STAMP_FIELDS(size)
+#define FIFO_STATS_STAMP_PTR_FIELD
+#define FIFO_STATS_STAMP(stamps, slot)          do { } while (0)
+#define FIFO_STATS_ADD_LATENCY(stats, stamps, slot) do { } while (0)
+#define FIFO_STATS_STAMP_PTR(stamps, slot)      do { } while (0)
+#define FIFO_STATS_ADD_LATENCY_PTR(stats, stamps, slot) do { } while (0)
+#define FIFO_STATS_STAMP_ATTACH(fifo, buffer)   ((void) (fifo), (void) (buffer), -ENOTSUP)
+#define FIFO_STATS_STAMP_RANGE(stamps, start, num, cap) do { } while (0)
+#endif
+
+#endif // FIFO_STATS_H_
@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2015 Jason Schmidlapp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "heap.h"
+
+#define HEAP_ARITY 4
+
+#define HEAP_PARENT(i)     (((i) - 1) / HEAP_ARITY)
+#define HEAP_FIRST_CHILD(i) ((i) * HEAP_ARITY + 1)
+
+static inline void HEAP_Place(HEAP_Generic_t *heap, size_t index, HEAP_node_t *node)
+{
+	heap->nodes[index] = node;
+	node->index = index;
+}
+
+/* Moves node up from index until its parent is not larger; returns the final index */
+static size_t HEAP_SiftUp(HEAP_Generic_t *heap, size_t index, HEAP_node_t *node)
+{
+	while (index > 0) {
+		size_t parent = HEAP_PARENT(index);
+
+		if (heap->nodes[parent]->key <= node->key)
+			break;
+
+		HEAP_Place(heap, index, heap->nodes[parent]);
+		index = parent;
+	}
+
+	HEAP_Place(heap, index, node);
+	return index;
+}
+
+static void HEAP_SiftDown(HEAP_Generic_t *heap, size_t index, HEAP_node_t *node)
+{
+	for (;;) {
+		size_t first = HEAP_FIRST_CHILD(index);
+		size_t last = first + HEAP_ARITY;
+		size_t smallest, i;
+
+		if (first >= heap->count)
+			break;
+
+		if (last > heap->count)
+			last = heap->count;
+
+		smallest = first;
+		for (i=first+1; i<last; i++) {
+			if (heap->nodes[i]->key < heap->nodes[smallest]->key)
+				smallest = i;
+		}
+
+		if (heap->nodes[smallest]->key >= node->key)
+			break;
+
+		HEAP_Place(heap, index, heap->nodes[smallest]);
+		index = smallest;
+	}
+
+	HEAP_Place(heap, index, node);
+}
+
+void _HEAP_Init(HEAP_Generic_t *heap, size_t capacity)
+{
+	heap->capacity = capacity;
+	heap->count = 0;
+}
+
+int _HEAP_Insert(HEAP_Generic_t *heap, HEAP_node_t *node)
+{
+	if (heap->count == heap->capacity)
+		return -ENOBUFS;
+
+	HEAP_SiftUp(heap, heap->count++, node);
+	return 0;
+}
+
+HEAP_node_t *_HEAP_PopMin(HEAP_Generic_t *heap)
+{
+	HEAP_node_t *min;
+
+	if (heap->count == 0)
+		return NULL;
+
+	min = heap->nodes[0];
+	if (--heap->count > 0)
+		HEAP_SiftDown(heap, 0, heap->nodes[heap->count]);
+
+	min->index = HEAP_NOT_QUEUED;
+	return min;
+}
+
+int _HEAP_DecreaseKey(HEAP_Generic_t *heap, HEAP_node_t *node, uint64_t key)
+{
+	if ((node->index >= heap->count) || (heap->nodes[node->index] != node) || (key > node->key))
+		return -EINVAL;
+
+	node->key = key;
+	HEAP_SiftUp(heap, node->index, node);
+	return 0;
+}
+
+int _HEAP_Remove(HEAP_Generic_t *heap, HEAP_node_t *node)
+{
+	size_t index = node->index;
+	HEAP_node_t *last;
+
+	if ((index >= heap->count) || (heap->nodes[index] != node))
+		return -EINVAL;
+
+	last = heap->nodes[--heap->count];
+	if (last != node) {
+		/* The last entry fills the hole and may have to move either way */
+		if (HEAP_SiftUp(heap, index, last) == index)
+			HEAP_SiftDown(heap, index, last);
+	}
+
+	node->index = HEAP_NOT_QUEUED;
+	return 0;
+}
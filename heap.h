@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2015 Jason Schmidlapp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef HEAP_H_
+#define HEAP_H_
+
+/*
+ * Intrusive min-heap, e.g. for earliest deadline first dispatch.  Like the list in
+ * list.h, the heap doesn't own the entries: a HEAP_node_t is embedded in the user's
+ * structure and the heap only stores pointers to those nodes.  Each node holds its key
+ * (smaller is earlier) and its current position in the heap, which is what makes
+ * decrease-key and removal of an arbitrary entry O(log n) rather than a search.
+ *
+ * The heap is 4-ary, so the tree is half as deep as a binary heap and a sift-down does
+ * half as many levels.  The four child pointers of a node are adjacent in the array,
+ * but the keys live in the nodes themselves, so comparing the children still follows
+ * each pointer into the entry's own cache line.
+ *
+ * typedef struct {
+ *     HEAP_node_t node;
+ *     ...
+ * } Timer_t;
+ *
+ * DECLARE_HEAP(timers, 256)
+ * HEAP(timers) timerHeap;
+ *
+ * HEAP_Init(timers, &timerHeap);
+ * timer->node.key = deadline;
+ * HEAP_Insert(timers, &timerHeap, &timer->node);        // 0, or -ENOBUFS if full
+ * HEAP_DecreaseKey(timers, &timerHeap, &timer->node, earlierDeadline);
+ * HEAP_Remove(timers, &timerHeap, &timer->node);        // cancel
+ *
+ * HEAP_node_t *next = HEAP_PopMin(timers, &timerHeap);  // NULL if empty
+ * Timer_t *t = HEAP_ENTRY(next, Timer_t, node);
+ *
+ * HEAP_PopMin and HEAP_Remove set the index of the node they take out to
+ * HEAP_NOT_QUEUED, so a node can tell whether it is queued.  The order of entries with
+ * equal keys is unspecified.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <errno.h>
+
+typedef struct
+{
+	uint64_t key;
+	size_t   index;
+} HEAP_node_t;
+
+#define HEAP_NOT_QUEUED ((size_t) -1)
+
+#define HEAP_ENTRY(ptr, type, member) ((type *) ((char *) (ptr) - offsetof(type, member)))
+
+/* Common prefix of every DECLARE_HEAP structure */
+typedef struct {
+	size_t       capacity;
+	size_t       count;
+	HEAP_node_t *nodes[];
+} HEAP_Generic_t;
+
+void         _HEAP_Init(HEAP_Generic_t *heap, size_t capacity);
+int          _HEAP_Insert(HEAP_Generic_t *heap, HEAP_node_t *node);
+HEAP_node_t *_HEAP_PopMin(HEAP_Generic_t *heap);
+int          _HEAP_DecreaseKey(HEAP_Generic_t *heap, HEAP_node_t *node, uint64_t key);
+int          _HEAP_Remove(HEAP_Generic_t *heap, HEAP_node_t *node);
+
+#define HEAP_Init(name, heap)                   HEAP_Init_##name##_(heap)
+#define HEAP_Insert(name, heap, node)           HEAP_Insert_##name##_(heap, node)
+#define HEAP_PeekMin(name, heap)                HEAP_PeekMin_##name##_(heap)
+#define HEAP_PopMin(name, heap)                 HEAP_PopMin_##name##_(heap)
+#define HEAP_DecreaseKey(name, heap, node, key) HEAP_DecreaseKey_##name##_(heap, node, key)
+#define HEAP_Remove(name, heap, node)           HEAP_Remove_##name##_(heap, node)
+#define HEAP_Size(name, heap)                   HEAP_Size_##name##_(heap)
+#define HEAP_IsEmpty(name, heap)                HEAP_IsEmpty_##name##_(heap)
+
+#define HEAP(name) HEAP_##name##_t
+
+#define DECLARE_HEAP(name, size)                                                 \
+typedef struct {                                                                 \
+	size_t       capacity;                                                       \
+	size_t       count;                                                          \
+	HEAP_node_t *nodes[size];                                                    \
+} HEAP_##name##_t;                                                               \
+                                                                                 \
+static inline void HEAP_Init_##name##_(HEAP_##name##_t *heap)                    \
+{                                                                                \
+	_HEAP_Init((HEAP_Generic_t *) heap, (size));                                 \
+}                                                                                \
+                                                                                 \
+static inline int HEAP_Insert_##name##_(HEAP_##name##_t *heap, HEAP_node_t *node) \
+{                                                                                \
+	return _HEAP_Insert((HEAP_Generic_t *) heap, node);                          \
+}                                                                                \
+                                                                                 \
+static inline HEAP_node_t *HEAP_PeekMin_##name##_(HEAP_##name##_t *heap)         \
+{                                                                                \
+	return heap->count ? heap->nodes[0] : NULL;                                  \
+}                                                                                \
+                                                                                 \
+static inline HEAP_node_t *HEAP_PopMin_##name##_(HEAP_##name##_t *heap)          \
+{                                                                                \
+	return _HEAP_PopMin((HEAP_Generic_t *) heap);                                \
+}                                                                                \
+                                                                                 \
+static inline int HEAP_DecreaseKey_##name##_(HEAP_##name##_t *heap, HEAP_node_t *node, uint64_t key) \
+{                                                                                \
+	return _HEAP_DecreaseKey((HEAP_Generic_t *) heap, node, key);                \
+}                                                                                \
+                                                                                 \
+static inline int HEAP_Remove_##name##_(HEAP_##name##_t *heap, HEAP_node_t *node) \
+{                                                                                \
+	return _HEAP_Remove((HEAP_Generic_t *) heap, node);                          \
+}                                                                                \
+                                                                                 \
+static inline size_t HEAP_Size_##name##_(HEAP_##name##_t *heap)   { return heap->count; }      \
+static inline int    HEAP_IsEmpty_##name##_(HEAP_##name##_t *heap) { return (heap->count == 0); }
+
+#endif // HEAP_H_
@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) 2015 Jason Schmidlapp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+
+#include "hugemem.h"
+
+/* Linux 5.14; older kernels reject it with EINVAL, which is handled below */
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE 23
+#endif
+
+static size_t HUGEMEM_HugePageSize(void)
+{
+	static size_t hugePageSize;
+	char line[128];
+	FILE *fp;
+
+	if (hugePageSize)
+		return hugePageSize;
+
+	hugePageSize = HUGEMEM_DEFAULT_HUGE_PAGE_SIZE;
+
+	fp = fopen("/proc/meminfo", "r");
+	if (fp == NULL)
+		return hugePageSize;
+
+	while (fgets(line, sizeof(line), fp)) {
+		unsigned long kb;
+
+		if (sscanf(line, "Hugepagesize: %lu kB", &kb) == 1) {
+			hugePageSize = kb * 1024;
+			break;
+		}
+	}
+
+	fclose(fp);
+	return hugePageSize;
+}
+
+static size_t HUGEMEM_RoundUp(size_t size, size_t align)
+{
+	return (size + align - 1) & ~(align - 1);
+}
+
+static int HUGEMEM_Bind(void *addr, size_t size, int node)
+{
+	unsigned long nodeMask[4] = { 0 };
+	const unsigned long maxNode = sizeof(nodeMask) * 8;
+
+	if ((unsigned) node >= maxNode)
+		return -EINVAL;
+
+	nodeMask[node / (sizeof(nodeMask[0]) * 8)] |= 1ul << (node % (sizeof(nodeMask[0]) * 8));
+
+	if (syscall(SYS_mbind, addr, size, MPOL_BIND, nodeMask, maxNode + 1, 0) != 0)
+		return -errno;
+
+	return 0;
+}
+
+/* Faults in every page for writing; -errno if that fails (-EINVAL if not supported) */
+static int HUGEMEM_Populate(void *addr, size_t size)
+{
+	if (madvise(addr, size, MADV_POPULATE_WRITE) != 0)
+		return -errno;
+
+	return 0;
+}
+
+static void HUGEMEM_Touch(void *addr, size_t size, size_t pageSize)
+{
+	size_t i;
+
+	for (i=0; i<size; i+=pageSize)
+		((volatile char *) addr)[i] = 0;
+}
+
+/*
+ * Explicit huge pages are reserved from a system wide pool, so a range bound to a node
+ * that has no free huge pages left can still fail on first touch, with SIGBUS.  Such a
+ * range is always populated here, where the failure is an error return, and given up
+ * on if that fails.
+ */
+static int HUGEMEM_MapHuge(HUGEMEM_Info_t *info, size_t size, int node, int flags)
+{
+	size_t hugeSize = HUGEMEM_RoundUp(size, HUGEMEM_HugePageSize());
+	void *addr;
+	int result;
+
+	addr = mmap(NULL, hugeSize, PROT_READ | PROT_WRITE,
+	            MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	if (addr == MAP_FAILED)
+		return -errno;
+
+	if ((node >= 0) && (HUGEMEM_Bind(addr, hugeSize, node) == 0))
+		info->node = node;
+
+	if ((info->node >= 0) || (flags & HUGEMEM_PREFAULT)) {
+		result = HUGEMEM_Populate(addr, hugeSize);
+
+		/* Unbound, the pages were reserved at mmap time, so touching them is safe */
+		if ((result == -EINVAL) && (info->node < 0)) {
+			HUGEMEM_Touch(addr, hugeSize, HUGEMEM_HugePageSize());
+			result = 0;
+		}
+
+		if (result != 0) {
+			munmap(addr, hugeSize);
+			info->node = -1;
+			return result;
+		}
+
+		info->prefaulted = 1;
+	}
+
+	info->addr = addr;
+	info->size = hugeSize;
+	info->pageSize = HUGEMEM_HugePageSize();
+	info->hugetlb = 1;
+	return 0;
+}
+
+/* Base pages, aligned to the huge page size so transparent huge pages can back them */
+static int HUGEMEM_MapSmall(HUGEMEM_Info_t *info, size_t size, int node, int flags)
+{
+	size_t pageSize = (size_t) sysconf(_SC_PAGESIZE);
+	size_t align = HUGEMEM_HugePageSize();
+	size_t mapSize, head, tail;
+	char *raw, *addr;
+
+	if (align < pageSize)
+		align = pageSize;
+
+	info->pageSize = pageSize;
+	info->size = HUGEMEM_RoundUp(size, pageSize);
+
+	/* Over-allocate by up to one huge page and trim both ends */
+	mapSize = info->size + align - pageSize;
+	raw = mmap(NULL, mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (raw == MAP_FAILED)
+		return -errno;
+
+	addr = (char *) HUGEMEM_RoundUp((size_t) raw, align);
+	head = addr - raw;
+	tail = mapSize - head - info->size;
+	if (head)
+		munmap(raw, head);
+	if (tail)
+		munmap(addr + info->size, tail);
+
+#ifdef MADV_HUGEPAGE
+	info->thp = (madvise(addr, info->size, MADV_HUGEPAGE) == 0);
+#endif
+
+	/* Bind before the first touch, otherwise the pages are already placed */
+	if ((node >= 0) && (HUGEMEM_Bind(addr, info->size, node) == 0))
+		info->node = node;
+
+	if (flags & HUGEMEM_PREFAULT) {
+		if (HUGEMEM_Populate(addr, info->size) != 0)
+			HUGEMEM_Touch(addr, info->size, pageSize);
+		info->prefaulted = 1;
+	}
+
+	info->addr = addr;
+	return 0;
+}
+
+int HUGEMEM_Alloc(HUGEMEM_Info_t *info, size_t size, int node, int flags)
+{
+	if (info == NULL)
+		return -EINVAL;
+
+	memset(info, 0, sizeof(*info));
+	info->addr = NULL;
+	info->node = -1;
+
+	if (size == 0)
+		return (info->error = -EINVAL);
+
+	if (!(flags & HUGEMEM_NO_HUGE) && (HUGEMEM_MapHuge(info, size, node, flags) == 0))
+		return 0;
+
+	return (info->error = HUGEMEM_MapSmall(info, size, node, flags));
+}
+
+void HUGEMEM_Free(HUGEMEM_Info_t *info)
+{
+	if ((info == NULL) || (info->addr == NULL))
+		return;
+
+	munmap(info->addr, info->size);
+	info->addr = NULL;
+}
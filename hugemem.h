@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2015 Jason Schmidlapp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef HUGEMEM_H_
+#define HUGEMEM_H_
+
+/*
+ * Backing memory for large pools and rings.  The containers in this collection never
+ * allocate; normally their storage is static or provided by the caller.  For pools and
+ * rings of many megabytes that storage should come from huge pages (fewer TLB misses)
+ * on the NUMA node of the threads using it.  HUGEMEM_Alloc maps such memory:
+ *
+ * 1. mmap with MAP_HUGETLB (explicit huge pages, size rounded up to the huge page size).
+ * 2. If that fails (none reserved, unsupported), a normal anonymous mapping aligned to
+ *    the huge page size, with madvise(MADV_HUGEPAGE) to ask for transparent huge pages.
+ * 3. If node >= 0, mbind the range to that node (MPOL_BIND).  A failure here is not
+ *    fatal; the memory is still returned and info.node reads -1.
+ * 4. With HUGEMEM_PREFAULT, fault in every page (madvise(MADV_POPULATE_WRITE), or by
+ *    touching them on kernels without it) so no page faults (or remote first-touch
+ *    placement) happen later on the hot path.
+ *
+ * The huge page pool is shared by all nodes, so explicit huge pages bound to a node are
+ * always populated in step 4, even without HUGEMEM_PREFAULT.  If the node has run out,
+ * or the kernel can't populate and report the failure, the mapping falls back to step 2
+ * instead of raising SIGBUS on a later first touch.
+ *
+ * The HUGEMEM_Info_t filled in records what was actually obtained and must be passed
+ * to HUGEMEM_Free.
+ *
+ * HUGEMEM_Info_t mem;
+ * MEMPOOL(rxdesc) *pool = HUGEMEM_MempoolInit(rxdesc, &mem, 0, HUGEMEM_PREFAULT);
+ * ...
+ * HUGEMEM_Free(&mem);
+ *
+ * FIFO(rx) rxfifo;
+ * HUGEMEM_FifoInit(rx, &rxfifo, 1 << 20, &mem, 0, HUGEMEM_PREFAULT);
+ *
+ * Linux only.
+ */
+
+#include <stddef.h>
+#include <errno.h>
+
+#include "mempool.h"
+#include "fifo.h"
+
+/* Used if the huge page size can't be read from /proc/meminfo */
+#ifndef HUGEMEM_DEFAULT_HUGE_PAGE_SIZE
+#define HUGEMEM_DEFAULT_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+#endif
+
+/* Flags for HUGEMEM_Alloc */
+#define HUGEMEM_PREFAULT  0x1   /* touch every page before returning */
+#define HUGEMEM_NO_HUGE   0x2   /* don't try MAP_HUGETLB (transparent huge pages only) */
+
+typedef struct {
+	void  *addr;        /* start of the mapping */
+	size_t size;        /* bytes mapped (requested size rounded up to pageSize) */
+	size_t pageSize;    /* huge page size for MAP_HUGETLB, otherwise the base page size */
+	int    hugetlb;     /* 1 if explicit huge pages were obtained */
+	int    thp;         /* 1 if transparent huge pages were requested successfully */
+	int    node;        /* NUMA node the range is bound to, -1 if not bound */
+	int    prefaulted;  /* 1 if every page has been touched */
+	int    error;       /* what HUGEMEM_Alloc returned */
+} HUGEMEM_Info_t;
+
+/* Returns 0 and fills in info, or -errno if no memory could be mapped at all */
+int  HUGEMEM_Alloc(HUGEMEM_Info_t *info, size_t size, int node, int flags);
+void HUGEMEM_Free(HUGEMEM_Info_t *info);
+
+/* The result of the last HUGEMEM_Alloc on info, for use inside expression macros */
+static inline int HUGEMEM_Error(const HUGEMEM_Info_t *info)
+{
+	return (info == NULL) ? -EINVAL : info->error;
+}
+
+/* Allocates and initializes a MEMPOOL(name); evaluates to its address or NULL.  Uses
+ * MEMPOOL_InitLazy, so only HUGEMEM_PREFAULT touches the whole pool up front.
+ */
+#define HUGEMEM_MempoolInit(name, info, node, flags)                              \
+	((HUGEMEM_Alloc(info, sizeof(MEMPOOL(name)), node, flags) == 0) ?             \
+	 (MEMPOOL_InitLazy(name, (MEMPOOL(name) *) (info)->addr), (MEMPOOL(name) *) (info)->addr) : \
+	 (MEMPOOL(name) *) NULL)
+
+/* Allocates the working buffer of a DECLARE_FIFO and calls FIFO_Init; 0 or the -errno
+ * of whichever step failed
+ */
+#define HUGEMEM_FifoInit(name, fifo, numEntries, info, node, flags)                   \
+	((HUGEMEM_Alloc(info, (numEntries) * sizeof(*(fifo)->queue), node, flags) == 0) ? \
+	 FIFO_Init(name, fifo, numEntries, (void *) (info)->addr) :                       \
+	 HUGEMEM_Error(info))
+
+#endif // HUGEMEM_H_
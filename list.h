@@ -52,6 +52,44 @@ typedef struct node
 #define LIST_Empty(head) \
 	((head)->next == (head))
 
+/*
+ * Moves every entry of list to just after head, leaving list empty.  Constant time
+ * regardless of how many entries are moved.
+ */
+#define LIST_Splice(list, head) \
+	do { \
+		if (!LIST_Empty(list)) { \
+			LIST_node_t *_first = (list)->next; \
+			LIST_node_t *_last = (list)->prev; \
+			LIST_node_t *_at = (head)->next; \
+			_first->prev = (head); \
+			(head)->next = _first; \
+			_last->next = _at; \
+			_at->prev = _last; \
+			LIST_Init(list); \
+		} \
+	} while (0)
+
+/* As LIST_Splice, but the entries go before head (i.e. at the end of the list) */
+#define LIST_SpliceTail(list, head) \
+	LIST_Splice(list, (head)->prev)
+
+/*
+ * Moves the entries of head from the first one up to and including entry into list,
+ * which must be empty (its previous contents are discarded).  entry must be on head.
+ */
+#define LIST_CutPosition(list, head, entry) \
+	do { \
+		LIST_node_t *_first = (head)->next; \
+		LIST_node_t *_last = NODE(entry); \
+		(head)->next = _last->next; \
+		_last->next->prev = (head); \
+		(list)->next = _first; \
+		_first->prev = (list); \
+		(list)->prev = _last; \
+		_last->next = (list); \
+	} while (0)
+
 #define LIST_foreach(entry, head, type) \
 	for (entry = ((type *) (head)->next); NODE(entry) != (head); entry = (type *) (NODE(entry)->next))
 
@@ -64,6 +64,16 @@
  * Initializes the buffer pool with the given name (e.g. rxdesc) and the actual pool (e.g. rxd_pool)
  *
  *
+ * MEMPOOL_InitLazy(poolname, varname)
+ *
+ * Alternative to MEMPOOL_Init for large pools.  Instead of linking every buffer onto the
+ * free list (which touches every page of the pool), it only resets a bump index: buffers
+ * that have never been used are handed out in order from the index, and the free list
+ * only ever holds buffers that have been freed.  Initialization is constant time and the
+ * pool's memory is faulted in as it is first used.  Alloc, Free and the bulk calls work
+ * the same either way.
+ *
+ *
  * MEMPOOL_Alloc(poolname, varname)
  *
  * Allocates a buffer from the pool.  For instance:
@@ -78,11 +88,29 @@
  * MEMPOOL_Free(rxdesc, rxd_pool, ptr);
  *
  *
+ * MEMPOOL_AllocBulk(poolname, varname, ptrs, num)
+ * MEMPOOL_FreeBulk(poolname, varname, ptrs, num)
+ *
+ * Allocate or free num buffers at once, for burst oriented code.  AllocBulk is all or
+ * nothing: it returns 0 and fills ptrs[0..num-1], or returns -ENOMEM and allocates
+ * nothing.  It moves the whole burst from the free list to the in-use list with a
+ * single cut and splice.  FreeBulk still has to unlink each buffer from the in-use
+ * list, but returns the burst to the free list with one splice.
+ *
+ * RxDescriptor_t *burst[32];
+ *
+ * if (MEMPOOL_AllocBulk(rxdesc, rxd_pool, burst, 32) == 0) {
+ *     ...
+ *     MEMPOOL_FreeBulk(rxdesc, rxd_pool, burst, 32);
+ * }
+ *
+ *
  * Implementation note: This uses a lot of C preprocessor magic but should be portable
  * (e.g. doesn't use any additional GCC magic like typeof)
  */
 
 #include <stddef.h>
+#include <errno.h>
 #include "list.h"
 
 typedef struct
@@ -95,6 +123,7 @@ typedef struct
 typedef struct _MEMPOOL_##name {                                                			  \
 	LIST_node_t freeList;                                                            			  \
 	LIST_node_t storeList;                                                           			  \
+	size_t      nextUnused;                                                                   \
 	struct {                                                                    			  \
 		LIST_node_t node;                                                            			  \
 		type buffer;                                                            			  \
@@ -109,11 +138,24 @@ static inline void _MEMPOOL_Init_##name(_MEMPOOL_##name *pool) {
 	LIST_Init(&pool->storeList);                                                			  \
 	for (i=0; i<numElems; i++)                                                  			  \
 		LIST_Add(&pool->freeList, &(pool->bufferDescs[i]));                     			  \
-}                                                                               			  \
+	pool->nextUnused = numElems;                                                              \
+}                                                                                             \
+static inline void _MEMPOOL_InitLazy_##name(_MEMPOOL_##name *pool) {                          \
+	LIST_Init(&pool->freeList);                                                               \
+	LIST_Init(&pool->storeList);                                                              \
+	pool->nextUnused = 0;                                                                     \
+}                                                                                             \
 static inline type *_MEMPOOL_Alloc_##name(_MEMPOOL_##name *pool) {              			  \
 	void *ptr;                                                                  			  \
 	if (LIST_Empty(&pool->freeList)) {                                                        \
-		ptr = NULL;                                                                           \
+		if (pool->nextUnused < sizeof(pool->bufferDescs)/sizeof(pool->bufferDescs[0])) {     \
+			ptr = &pool->bufferDescs[pool->nextUnused].buffer;                                \
+			LIST_Add(&pool->storeList, &pool->bufferDescs[pool->nextUnused]);                 \
+			pool->nextUnused++;                                                               \
+		}                                                                                     \
+		else {                                                                                \
+			ptr = NULL;                                                                       \
+		}                                                                                     \
 	}                                                                                         \
 	else {                                                                                    \
 		BufferPoolDescriptor_t *desc = (BufferPoolDescriptor_t *) pool->freeList.next;        \
@@ -125,12 +167,57 @@ static inline type *_MEMPOOL_Alloc_##name(_MEMPOOL_##name *pool) {
 	return ptr;                                                                               \
 }                                                                                             \
 static inline void _MEMPOOL_Free_##name(_MEMPOOL_##name *pool, _MEMPOOL_type_##name *ptr) {   \
-	int i;                                                                                    \
-	for (i=0; i<sizeof(pool->bufferDescs)/sizeof(pool->bufferDescs[0]); i++) {                \
-		if (ptr == &pool->bufferDescs[i].buffer) {                                            \
-			LIST_Add(&pool->freeList, &pool->bufferDescs[i]);                                 \
-		}                                                                                     \
+	size_t offset = (char *) ptr - (char *) &pool->bufferDescs[0].buffer;                     \
+	size_t i = offset / sizeof(pool->bufferDescs[0]);                                         \
+	if ((i >= sizeof(pool->bufferDescs)/sizeof(pool->bufferDescs[0])) ||                      \
+	    (ptr != &pool->bufferDescs[i].buffer))                                                \
+		return;                                                                               \
+	LIST_Del(&pool->bufferDescs[i]);                                                          \
+	LIST_Add(&pool->freeList, &pool->bufferDescs[i]);                                         \
+}                                                                                             \
+static inline int _MEMPOOL_AllocBulk_##name(_MEMPOOL_##name *pool, type **ptrs, size_t num) { \
+	LIST_node_t burst;                                                                        \
+	LIST_node_t *node = &pool->freeList;                                                      \
+	size_t numElems = sizeof(pool->bufferDescs)/sizeof(pool->bufferDescs[0]);                 \
+	size_t i, fromList;                                                                       \
+	if (num == 0)                                                                             \
+		return 0;                                                                             \
+	for (i=0; (i<num) && (node->next != &pool->freeList); i++) {                              \
+		size_t index;                                                                         \
+		node = node->next;                                                                    \
+		index = ((char *) node - (char *) &pool->bufferDescs[0]) /                            \
+		        sizeof(pool->bufferDescs[0]);                                                 \
+		ptrs[i] = &pool->bufferDescs[index].buffer;                                           \
+	}                                                                                         \
+	fromList = i;                                                                             \
+	/* Whatever the free list can't supply comes from never used buffers */                   \
+	if (num - fromList > numElems - pool->nextUnused)                                         \
+		return -ENOMEM;                                                                       \
+	if (fromList) {                                                                           \
+		LIST_CutPosition(&burst, &pool->freeList, node);                                      \
+		LIST_Splice(&burst, &pool->storeList);                                                \
+	}                                                                                         \
+	for (i=fromList; i<num; i++) {                                                            \
+		ptrs[i] = &pool->bufferDescs[pool->nextUnused].buffer;                                \
+		LIST_Add(&pool->storeList, &pool->bufferDescs[pool->nextUnused]);                     \
+		pool->nextUnused++;                                                                   \
 	}                                                                                         \
+	return 0;                                                                                 \
+}                                                                                             \
+static inline void _MEMPOOL_FreeBulk_##name(_MEMPOOL_##name *pool, type **ptrs, size_t num) { \
+	LIST_node_t burst;                                                                        \
+	size_t i;                                                                                 \
+	LIST_Init(&burst);                                                                        \
+	for (i=0; i<num; i++) {                                                                   \
+		size_t offset = (char *) ptrs[i] - (char *) &pool->bufferDescs[0].buffer;             \
+		size_t index = offset / sizeof(pool->bufferDescs[0]);                                 \
+		if ((index >= sizeof(pool->bufferDescs)/sizeof(pool->bufferDescs[0])) ||              \
+		    (ptrs[i] != &pool->bufferDescs[index].buffer))                                    \
+			continue;                                                                         \
+		LIST_Del(&pool->bufferDescs[index]);                                                  \
+		LIST_Add(&burst, &pool->bufferDescs[index]);                                          \
+	}                                                                                         \
+	LIST_Splice(&burst, &pool->freeList);                                                     \
 }
 
 
@@ -138,8 +225,14 @@ static inline void _MEMPOOL_Free_##name(_MEMPOOL_##name *pool, _MEMPOOL_type_##n
 
 #define MEMPOOL_Init(name, pool) _MEMPOOL_Init_##name(pool)
 
-#define MEMPOOL_Alloc(name, pool) _MEMPOOL_Alloc_##name((_MEMPOOL_##name *) pool);
+#define MEMPOOL_InitLazy(name, pool) _MEMPOOL_InitLazy_##name(pool)
+
+#define MEMPOOL_Alloc(name, pool) _MEMPOOL_Alloc_##name((_MEMPOOL_##name *) pool)
 
 #define MEMPOOL_Free(name, pool, ptr) _MEMPOOL_Free_##name((_MEMPOOL_##name *) pool, ptr)
 
+#define MEMPOOL_AllocBulk(name, pool, ptrs, num) _MEMPOOL_AllocBulk_##name((_MEMPOOL_##name *) pool, ptrs, num)
+
+#define MEMPOOL_FreeBulk(name, pool, ptrs, num) _MEMPOOL_FreeBulk_##name((_MEMPOOL_##name *) pool, ptrs, num)
+
 #endif /* MEMPOOL_H_ */
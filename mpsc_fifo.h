@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2015 Jason Schmidlapp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef MPSC_FIFO_H_
+#define MPSC_FIFO_H_
+
+/*
+ * Multiple producer, single consumer variant of the simple FIFO.  The same size
+ * restrictions apply (a power of two, see simple_fifo.h).
+ *
+ * Producers claim a slot by advancing produce_count with a compare-and-swap, copy the
+ * data in, and then mark the slot ready through its sequence number.  The consumer
+ * reads slots strictly in claim order and never takes a lock; if a producer has
+ * claimed the next slot but not yet finished writing it, the consumer sees the FIFO
+ * as empty until it has.
+ *
+ * Slot sequence numbers: a slot at position p is free for the producer that claims p
+ * when seq == p, ready for the consumer when seq == p+1, and is handed back for the
+ * next lap by setting seq = p+size.
+ *
+ * DECLARE_MPSC_FIFO(LogRecord_t, log, 1024)
+ * MPSC(log) logfifo;
+ *
+ * MPSC_Init(log, &logfifo);
+ * MPSC_TryPush(log, &logfifo, record);    // any thread; -EAGAIN when full
+ * MPSC_TryPop(log, &logfifo, &record);    // consumer thread; -EAGAIN when empty
+ *
+ * This needs the GCC/clang __atomic builtins.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <errno.h>
+
+#include "simple_fifo.h"
+
+#if !defined(__GNUC__)
+#error "mpsc_fifo.h requires the __atomic builtins"
+#endif
+
+#ifndef MPSC_CACHE_LINE
+#define MPSC_CACHE_LINE 64
+#endif
+
+#define MPSC_Init(name, fifo)           MPSC_Init_##name##_(fifo)
+#define MPSC_TryPush(name, fifo, data)  MPSC_TryPush_##name##_(fifo, data)
+#define MPSC_Push(name, fifo, data)     MPSC_Push_##name##_(fifo, data)
+#define MPSC_TryPop(name, fifo, pdata)  MPSC_TryPop_##name##_(fifo, pdata)
+#define MPSC_IsEmpty(name, fifo)        MPSC_IsEmpty_##name##_(fifo)
+
+#define MPSC(name) MPSC_##name##_t
+
+#define DECLARE_MPSC_FIFO(type, name, size)                                      \
+typedef struct {                                                                 \
+	size_t seq;                                                                  \
+	type   data;                                                                 \
+} MPSC_##name##_slot_t;                                                          \
+                                                                                 \
+typedef struct {                                                                 \
+	size_t produce_count;                                                        \
+	char   pad0[MPSC_CACHE_LINE - sizeof(size_t)];                               \
+	size_t consume_count;                                                        \
+	char   pad1[MPSC_CACHE_LINE - sizeof(size_t)];                               \
+	MPSC_##name##_slot_t buffer[size];                                           \
+} MPSC_##name##_t;                                                               \
+                                                                                 \
+static inline int MPSC_Init_##name##_(MPSC_##name##_t *fifo)                     \
+{                                                                                \
+	size_t i;                                                                    \
+	if (!fifo)                                                                   \
+		return -1;                                                               \
+	fifo->produce_count = 0;                                                     \
+	fifo->consume_count = 0;                                                     \
+	for (i=0; i<size; i++)                                                       \
+		fifo->buffer[i].seq = i;                                                 \
+	return 0;                                                                    \
+}                                                                                \
+                                                                                 \
+static inline int MPSC_TryPush_##name##_(MPSC_##name##_t *fifo, type data)       \
+{                                                                                \
+	size_t pos = __atomic_load_n(&fifo->produce_count, __ATOMIC_RELAXED);        \
+	MPSC_##name##_slot_t *slot;                                                  \
+	for (;;) {                                                                   \
+		intptr_t diff;                                                           \
+		slot = &fifo->buffer[MOD2(pos, size)];                                   \
+		diff = (intptr_t) SFIFO_LOAD_ACQUIRE(&slot->seq) - (intptr_t) pos;       \
+		if (diff == 0) {                                                         \
+			if (__atomic_compare_exchange_n(&fifo->produce_count, &pos, pos + 1, \
+			                                1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) \
+				break;                                                           \
+		}                                                                        \
+		else if (diff < 0) {                                                     \
+			return -EAGAIN;                                                      \
+		}                                                                        \
+		else {                                                                   \
+			pos = __atomic_load_n(&fifo->produce_count, __ATOMIC_RELAXED);       \
+		}                                                                        \
+	}                                                                            \
+	slot->data = data;                                                           \
+	SFIFO_STORE_RELEASE(&slot->seq, pos + 1);                                    \
+	return 0;                                                                    \
+}                                                                                \
+                                                                                 \
+static inline void MPSC_Push_##name##_(MPSC_##name##_t *fifo, type data)         \
+{                                                                                \
+	while (MPSC_TryPush_##name##_(fifo, data) != 0)                              \
+		;                                                                        \
+}                                                                                \
+                                                                                 \
+static inline int MPSC_TryPop_##name##_(MPSC_##name##_t *fifo, type *data)       \
+{                                                                                \
+	size_t pos = fifo->consume_count;                                            \
+	MPSC_##name##_slot_t *slot = &fifo->buffer[MOD2(pos, size)];                 \
+	if (SFIFO_LOAD_ACQUIRE(&slot->seq) != pos + 1)                               \
+		return -EAGAIN;                                                          \
+	*data = slot->data;                                                          \
+	SFIFO_STORE_RELEASE(&slot->seq, pos + size);                                 \
+	fifo->consume_count = pos + 1;                                               \
+	return 0;                                                                    \
+}                                                                                \
+                                                                                 \
+static inline int MPSC_IsEmpty_##name##_(MPSC_##name##_t *fifo)                  \
+{                                                                                \
+	size_t pos = fifo->consume_count;                                            \
+	return (SFIFO_LOAD_ACQUIRE(&fifo->buffer[MOD2(pos, size)].seq) != pos + 1);  \
+}
+
+#endif // MPSC_FIFO_H_
@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2015 Jason Schmidlapp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "msg_ring.h"
+
+int MSGRING_Init(MSGRING_t *ring, void *buffer, size_t size)
+{
+	if ((ring == NULL) || (buffer == NULL) || ((uintptr_t) buffer & 7) ||
+	    (size < 4 * sizeof(MSGRING_Header_t)) || (size & (size - 1)))
+		return -EINVAL;
+
+	ring->produce_count = 0;
+	ring->consume_count = 0;
+	ring->padding = 0;
+	ring->size = size;
+	ring->buffer = buffer;
+	return 0;
+}
+
+void *MSGRING_Reserve(MSGRING_t *ring, size_t maxLen)
+{
+	size_t produce = ring->produce_count;
+	size_t space = ring->size - (produce - SFIFO_LOAD_ACQUIRE(&ring->consume_count));
+	size_t pos = MOD2(produce, ring->size);
+	size_t total = MSGRING_ALIGN(sizeof(MSGRING_Header_t) + maxLen);
+	size_t pad = 0;
+
+	if (maxLen > MSGRING_MaxLen(ring))
+		return NULL;
+
+	/* Doesn't fit before the end of the buffer: pad it out and start at the beginning */
+	if (ring->size - pos < total) {
+		pad = ring->size - pos;
+		pos = 0;
+	}
+
+	if (pad + total > space)
+		return NULL;
+
+	ring->padding = pad;
+	return ring->buffer + pos + sizeof(MSGRING_Header_t);
+}
+
+int MSGRING_Commit(MSGRING_t *ring, size_t len, uint32_t type)
+{
+	size_t produce = ring->produce_count;
+	MSGRING_Header_t *header;
+
+	/* The consumer would take it for padding and skip it */
+	if (type == MSGRING_TYPE_PAD)
+		return -EINVAL;
+
+	if (ring->padding) {
+		header = (MSGRING_Header_t *) (ring->buffer + MOD2(produce, ring->size));
+		header->len = ring->padding - sizeof(MSGRING_Header_t);
+		header->type = MSGRING_TYPE_PAD;
+		produce += ring->padding;
+	}
+
+	header = (MSGRING_Header_t *) (ring->buffer + MOD2(produce, ring->size));
+	header->len = len;
+	header->type = type;
+
+	/* The message may be shorter than reserved; only its own space is used up */
+	produce += MSGRING_ALIGN(sizeof(MSGRING_Header_t) + len);
+	ring->padding = 0;
+	SFIFO_STORE_RELEASE(&ring->produce_count, produce);
+	return 0;
+}
+
+int MSGRING_Write(MSGRING_t *ring, uint32_t type, const void *data, size_t len)
+{
+	void *p;
+
+	if (type == MSGRING_TYPE_PAD)
+		return -EINVAL;
+
+	if (len > MSGRING_MaxLen(ring))
+		return -EMSGSIZE;
+
+	p = MSGRING_Reserve(ring, len);
+	if (p == NULL)
+		return -ENOBUFS;
+
+	memcpy(p, data, len);
+	return MSGRING_Commit(ring, len, type);
+}
+
+const void *MSGRING_Peek(MSGRING_t *ring, size_t *len, uint32_t *type)
+{
+	size_t consume = ring->consume_count;
+	size_t produce = SFIFO_LOAD_ACQUIRE(&ring->produce_count);
+	MSGRING_Header_t *header;
+
+	if (produce == consume)
+		return NULL;
+
+	header = (MSGRING_Header_t *) (ring->buffer + MOD2(consume, ring->size));
+	if (header->type == MSGRING_TYPE_PAD) {
+		/* Always followed by a real message, committed together with it */
+		consume += sizeof(MSGRING_Header_t) + header->len;
+		SFIFO_STORE_RELEASE(&ring->consume_count, consume);
+		header = (MSGRING_Header_t *) (ring->buffer + MOD2(consume, ring->size));
+	}
+
+	*len = header->len;
+	if (type)
+		*type = header->type;
+	return header + 1;
+}
+
+void MSGRING_Release(MSGRING_t *ring)
+{
+	size_t consume = ring->consume_count;
+	MSGRING_Header_t *header = (MSGRING_Header_t *) (ring->buffer + MOD2(consume, ring->size));
+
+	SFIFO_STORE_RELEASE(&ring->consume_count, consume + MSGRING_ALIGN(sizeof(MSGRING_Header_t) + header->len));
+}
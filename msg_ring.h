@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2015 Jason Schmidlapp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef MSG_RING_H_
+#define MSG_RING_H_
+
+/*
+ * Single producer, single consumer ring of variable length messages.  Each message is
+ * a MSGRING_Header_t (length and a user defined type) followed by the payload, padded
+ * to 8 bytes, and is always contiguous in memory: if a message doesn't fit before the
+ * end of the buffer, the producer fills the rest with a pad record and the message
+ * starts again at the beginning.  The consumer skips pad records transparently.
+ *
+ * Messages are built and read in place, so the only copy is the one the producer makes
+ * when filling in the payload:
+ *
+ * static uint8_t storage[65536] __attribute__((aligned(8)));
+ * MSGRING_t ring;
+ *
+ * MSGRING_Init(&ring, storage, sizeof(storage));      // size must be a power of two
+ *
+ * Producer:
+ *     uint8_t *p = MSGRING_Reserve(&ring, maxLen);     // NULL if there is no room
+ *     len = build_message(p);
+ *     MSGRING_Commit(&ring, len, MSG_TYPE_FOO);        // len <= maxLen; 0, or -EINVAL
+ *                                                      // for MSGRING_TYPE_PAD
+ *
+ * Consumer:
+ *     const uint8_t *p = MSGRING_Peek(&ring, &len, &type);   // NULL if empty
+ *     handle_message(type, p, len);
+ *     MSGRING_Release(&ring);
+ *
+ * MSGRING_Write copies a ready made message in (reserve + memcpy + commit).
+ *
+ * MSGRING_TYPE_PAD is reserved for the pad records and can't be used as a message type.
+ * A Commit with it is rejected and publishes nothing; the reservation stays open.
+ *
+ * The largest message is MSGRING_MaxLen(ring), half the ring less the header, which
+ * guarantees it fits whatever the wrap position.  Synchronization follows the simple
+ * FIFO (free running byte counters, acquire/release, see simple_fifo.h).
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <errno.h>
+
+#include "simple_fifo.h"
+
+#ifndef MSGRING_CACHE_LINE
+#define MSGRING_CACHE_LINE 64
+#endif
+
+/* Reserved message type marking padding up to the end of the buffer */
+#define MSGRING_TYPE_PAD 0xffffffffu
+
+typedef struct {
+	uint32_t len;     /* payload bytes, excluding this header and the alignment padding */
+	uint32_t type;
+} MSGRING_Header_t;
+
+typedef struct {
+	size_t   produce_count;
+	size_t   padding;        /* pad record the last Reserve needs at the end of the buffer */
+	char     pad0[MSGRING_CACHE_LINE - 2 * sizeof(size_t)];
+	size_t   consume_count;
+	char     pad1[MSGRING_CACHE_LINE - sizeof(size_t)];
+	size_t   size;
+	uint8_t *buffer;
+} MSGRING_t;
+
+#define MSGRING_ALIGN(len) (((len) + 7) & ~(size_t) 7)
+
+#define MSGRING_MaxLen(ring) ((ring)->size / 2 - sizeof(MSGRING_Header_t))
+
+int            MSGRING_Init(MSGRING_t *ring, void *buffer, size_t size);
+void          *MSGRING_Reserve(MSGRING_t *ring, size_t maxLen);
+int            MSGRING_Commit(MSGRING_t *ring, size_t len, uint32_t type);
+int            MSGRING_Write(MSGRING_t *ring, uint32_t type, const void *data, size_t len);
+const void    *MSGRING_Peek(MSGRING_t *ring, size_t *len, uint32_t *type);
+void           MSGRING_Release(MSGRING_t *ring);
+
+static inline int MSGRING_IsEmpty(MSGRING_t *ring)
+{
+	return (SFIFO_LOAD_ACQUIRE(&ring->produce_count) == ring->consume_count);
+}
+
+#endif // MSG_RING_H_
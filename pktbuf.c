@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) 2015 Jason Schmidlapp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+
+#include "pktbuf.h"
+
+static void PKTBUF_PoolLock(PKTBUF_Pool_t *pool)
+{
+	while (__atomic_exchange_n(&pool->lock, 1, __ATOMIC_ACQUIRE))
+		;
+}
+
+static void PKTBUF_PoolUnlock(PKTBUF_Pool_t *pool)
+{
+	__atomic_store_n(&pool->lock, 0, __ATOMIC_RELEASE);
+}
+
+static PKTBUF_t *PKTBUF_GetHeader(PKTBUF_Pool_t *pool)
+{
+	PKTBUF_t *seg;
+
+	PKTBUF_PoolLock(pool);
+	seg = pool->alloc(pool);
+	PKTBUF_PoolUnlock(pool);
+
+	if (seg == NULL)
+		return NULL;
+
+	seg->next = NULL;
+	seg->direct = seg;
+	seg->pool = pool;
+	seg->bufLen = pool->dataRoom;
+	seg->data = seg->buf + pool->headroom;
+	seg->len = 0;
+	seg->pktLen = 0;
+	seg->refcnt = 1;
+	seg->numSegs = 1;
+
+	return seg;
+}
+
+/* Drops one reference on a single segment, returning it (and the reference it holds on
+ * its direct segment, if any) once the count reaches zero.
+ */
+static void PKTBUF_Release(PKTBUF_t *seg)
+{
+	PKTBUF_t *direct;
+
+	if (__atomic_sub_fetch(&seg->refcnt, 1, __ATOMIC_ACQ_REL) != 0)
+		return;
+
+	direct = seg->direct;
+
+	PKTBUF_PoolLock(seg->pool);
+	seg->pool->free(seg->pool, seg);
+	PKTBUF_PoolUnlock(seg->pool);
+
+	if (direct != seg)
+		PKTBUF_Release(direct);
+}
+
+static PKTBUF_t *PKTBUF_Last(PKTBUF_t *pkt)
+{
+	while (pkt->next != NULL)
+		pkt = pkt->next;
+
+	return pkt;
+}
+
+PKTBUF_t *_PKTBUF_Alloc(PKTBUF_Pool_t *pool)
+{
+	if (pool == NULL)
+		return NULL;
+
+	return PKTBUF_GetHeader(pool);
+}
+
+void PKTBUF_Free(PKTBUF_t *pkt)
+{
+	while (pkt != NULL) {
+		PKTBUF_t *next = pkt->next;
+
+		PKTBUF_Release(pkt);
+		pkt = next;
+	}
+}
+
+void PKTBUF_RefcntUpdate(PKTBUF_t *seg, int delta)
+{
+	__atomic_add_fetch(&seg->refcnt, delta, __ATOMIC_ACQ_REL);
+}
+
+/* Makes an indirect segment covering [offset, offset+len) of seg */
+static PKTBUF_t *PKTBUF_Attach(PKTBUF_t *seg, PKTBUF_Pool_t *pool, size_t offset, size_t len)
+{
+	PKTBUF_t *clone = PKTBUF_GetHeader(pool);
+
+	if (clone == NULL)
+		return NULL;
+
+	clone->direct = seg->direct;
+	clone->buf = seg->buf;
+	clone->bufLen = seg->bufLen;
+	clone->data = seg->data + offset;
+	clone->len = len;
+	PKTBUF_RefcntUpdate(seg->direct, 1);
+
+	return clone;
+}
+
+PKTBUF_t *_PKTBUF_Slice(PKTBUF_t *pkt, PKTBUF_Pool_t *pool, size_t offset, size_t len)
+{
+	PKTBUF_t *head = NULL;
+	PKTBUF_t *tail = NULL;
+	PKTBUF_t *seg;
+
+	if ((pkt == NULL) || (pool == NULL) || (offset + len > pkt->pktLen))
+		return NULL;
+
+	for (seg = pkt; (seg != NULL) && (len > 0); seg = seg->next) {
+		PKTBUF_t *clone;
+		size_t num;
+
+		if (offset >= seg->len) {
+			offset -= seg->len;
+			continue;
+		}
+
+		num = seg->len - offset;
+		if (num > len)
+			num = len;
+
+		clone = PKTBUF_Attach(seg, pool, offset, num);
+		if (clone == NULL) {
+			PKTBUF_Free(head);
+			return NULL;
+		}
+
+		if (head == NULL) {
+			head = clone;
+		}
+		else {
+			tail->next = clone;
+			head->numSegs++;
+		}
+
+		tail = clone;
+		head->pktLen += num;
+		len -= num;
+		offset = 0;
+	}
+
+	/* A zero length slice still yields a (empty) packet */
+	if (head == NULL)
+		head = PKTBUF_Attach(pkt, pool, 0, 0);
+
+	return head;
+}
+
+PKTBUF_t *_PKTBUF_Clone(PKTBUF_t *pkt, PKTBUF_Pool_t *pool)
+{
+	if (pkt == NULL)
+		return NULL;
+
+	return _PKTBUF_Slice(pkt, pool, 0, pkt->pktLen);
+}
+
+uint8_t *PKTBUF_Prepend(PKTBUF_t *pkt, size_t len)
+{
+	if (PKTBUF_IsIndirect(pkt) || (PKTBUF_Headroom(pkt) < len))
+		return NULL;
+
+	pkt->data -= len;
+	pkt->len += len;
+	pkt->pktLen += len;
+
+	return pkt->data;
+}
+
+uint8_t *PKTBUF_Append(PKTBUF_t *pkt, size_t len)
+{
+	PKTBUF_t *last = PKTBUF_Last(pkt);
+	uint8_t *tail;
+
+	if (PKTBUF_IsIndirect(last) || (PKTBUF_Tailroom(last) < len))
+		return NULL;
+
+	tail = last->data + last->len;
+	last->len += len;
+	pkt->pktLen += len;
+
+	return tail;
+}
+
+uint8_t *PKTBUF_Adj(PKTBUF_t *pkt, size_t len)
+{
+	if (len > pkt->len)
+		return NULL;
+
+	pkt->data += len;
+	pkt->len -= len;
+	pkt->pktLen -= len;
+
+	return pkt->data;
+}
+
+int PKTBUF_Trim(PKTBUF_t *pkt, size_t len)
+{
+	PKTBUF_t *last = PKTBUF_Last(pkt);
+
+	if (len > last->len)
+		return -EINVAL;
+
+	last->len -= len;
+	pkt->pktLen -= len;
+
+	return 0;
+}
+
+int PKTBUF_Chain(PKTBUF_t *head, PKTBUF_t *tail)
+{
+	if ((head == NULL) || (tail == NULL))
+		return -EINVAL;
+
+	PKTBUF_Last(head)->next = tail;
+	head->numSegs += tail->numSegs;
+	head->pktLen += tail->pktLen;
+
+	return 0;
+}
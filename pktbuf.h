@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2015 Jason Schmidlapp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef PKTBUF_H_
+#define PKTBUF_H_
+
+/*
+ * Reference counted, chainable packet buffers allocated from a MEMPOOL.
+ *
+ * Each PKTBUF_t is a header followed by a data room of fixed size.  The valid data is
+ * a window [data, data+len) inside the room, so there is headroom in front of it (for
+ * prepending protocol headers) and tailroom behind it.  Buffers can be chained through
+ * next into multi-segment packets; the first segment holds the totals for the chain.
+ *
+ * Sharing is done by cloning rather than copying: PKTBUF_Clone and PKTBUF_Slice
+ * allocate new headers ("indirect" segments) that point into the data room of the
+ * original ("direct") segment and hold a reference on it.  The direct segment only goes
+ * back to its pool once every clone has been freed.  Reference counts are atomic, so
+ * clones may be freed from other threads.  Pool alloc/free is serialized with a small
+ * spinlock inside the pool.
+ *
+ * Data reached through an indirect segment is shared and must be treated as read only;
+ * PKTBUF_Prepend and PKTBUF_Append refuse to grow indirect segments.
+ *
+ * Usage:
+ *
+ * DECLARE_PKTBUF_POOL(rx, 64, 2048)          // 64 buffers of 2048 bytes
+ * static PKTBUF_POOL(rx) rxPool;
+ *
+ * PKTBUF_PoolInit(rx, &rxPool, 128);          // 128 bytes of headroom
+ * PKTBUF_t *pkt = PKTBUF_Alloc(&rxPool);
+ * memcpy(PKTBUF_Append(pkt, len), payload, len);
+ * PKTBUF_t *copy = PKTBUF_Clone(pkt, &rxPool); // no data copied
+ * PKTBUF_Free(pkt);
+ * PKTBUF_Free(copy);                           // data room returns to the pool here
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <errno.h>
+
+#include "mempool.h"
+
+typedef struct PKTBUF_Pool PKTBUF_Pool_t;
+
+typedef struct PKTBUF {
+	struct PKTBUF *next;      /* Next segment of the packet, or NULL */
+	struct PKTBUF *direct;    /* Segment owning the data room (this one unless cloned) */
+	PKTBUF_Pool_t *pool;      /* Pool this header came from */
+	uint8_t       *buf;       /* Start of the data room */
+	uint8_t       *data;      /* Start of valid data */
+	size_t         bufLen;    /* Size of the data room */
+	size_t         len;       /* Valid bytes in this segment */
+	size_t         pktLen;    /* Valid bytes in the whole chain (first segment only) */
+	uint32_t       refcnt;
+	uint16_t       numSegs;   /* Segments in the chain (first segment only) */
+} PKTBUF_t;
+
+struct PKTBUF_Pool {
+	PKTBUF_t *(*alloc)(PKTBUF_Pool_t *pool);
+	void      (*free)(PKTBUF_Pool_t *pool, PKTBUF_t *buf);
+	size_t    dataRoom;
+	size_t    headroom;
+	int       lock;
+};
+
+PKTBUF_t *_PKTBUF_Alloc(PKTBUF_Pool_t *pool);
+PKTBUF_t *_PKTBUF_Clone(PKTBUF_t *pkt, PKTBUF_Pool_t *pool);
+PKTBUF_t *_PKTBUF_Slice(PKTBUF_t *pkt, PKTBUF_Pool_t *pool, size_t offset, size_t len);
+void      PKTBUF_Free(PKTBUF_t *pkt);
+void      PKTBUF_RefcntUpdate(PKTBUF_t *seg, int delta);
+uint8_t  *PKTBUF_Prepend(PKTBUF_t *pkt, size_t len);
+uint8_t  *PKTBUF_Append(PKTBUF_t *pkt, size_t len);
+uint8_t  *PKTBUF_Adj(PKTBUF_t *pkt, size_t len);
+int       PKTBUF_Trim(PKTBUF_t *pkt, size_t len);
+int       PKTBUF_Chain(PKTBUF_t *head, PKTBUF_t *tail);
+
+static inline size_t PKTBUF_Headroom(PKTBUF_t *seg)
+{
+	return seg->data - seg->buf;
+}
+
+static inline size_t PKTBUF_Tailroom(PKTBUF_t *seg)
+{
+	return (seg->buf + seg->bufLen) - (seg->data + seg->len);
+}
+
+static inline int PKTBUF_IsIndirect(PKTBUF_t *seg)
+{
+	return (seg->direct != seg);
+}
+
+#define PKTBUF_Mtod(seg, type) ((type) (seg)->data)
+
+#define DECLARE_PKTBUF_POOL(name, numBufs, dataRoomSize)                          \
+typedef struct {                                                                  \
+	PKTBUF_t hdr;                                                                 \
+	uint8_t  room[dataRoomSize];                                                  \
+} PKTBUF_elem_##name##_t;                                                         \
+                                                                                  \
+DECLARE_MEMPOOL(PKTBUF_elem_##name##_t, numBufs, _pktbuf_##name)                  \
+                                                                                  \
+typedef struct {                                                                  \
+	PKTBUF_Pool_t pool;                                                           \
+	MEMPOOL(_pktbuf_##name) mem;                                                  \
+} PKTBUF_POOL_##name##_t;                                                         \
+                                                                                  \
+static inline PKTBUF_t *_PKTBUF_PoolAlloc_##name(PKTBUF_Pool_t *pool)             \
+{                                                                                 \
+	PKTBUF_POOL_##name##_t *p = (PKTBUF_POOL_##name##_t *) pool;                  \
+	PKTBUF_elem_##name##_t *elem = MEMPOOL_Alloc(_pktbuf_##name, &p->mem);        \
+	if (elem == NULL)                                                             \
+		return NULL;                                                              \
+	elem->hdr.buf = elem->room;                                                   \
+	return &elem->hdr;                                                            \
+}                                                                                 \
+                                                                                  \
+static inline void _PKTBUF_PoolFree_##name(PKTBUF_Pool_t *pool, PKTBUF_t *buf)    \
+{                                                                                 \
+	PKTBUF_POOL_##name##_t *p = (PKTBUF_POOL_##name##_t *) pool;                  \
+	MEMPOOL_Free(_pktbuf_##name, &p->mem, (PKTBUF_elem_##name##_t *) buf);        \
+}                                                                                 \
+                                                                                  \
+static inline int PKTBUF_PoolInit_##name##_(PKTBUF_POOL_##name##_t *p, size_t headroom) \
+{                                                                                 \
+	if ((p == NULL) || (headroom > (dataRoomSize)))                               \
+		return -EINVAL;                                                           \
+	MEMPOOL_Init(_pktbuf_##name, &p->mem);                                        \
+	p->pool.alloc = _PKTBUF_PoolAlloc_##name;                                     \
+	p->pool.free = _PKTBUF_PoolFree_##name;                                       \
+	p->pool.dataRoom = (dataRoomSize);                                            \
+	p->pool.headroom = headroom;                                                  \
+	p->pool.lock = 0;                                                             \
+	return 0;                                                                     \
+}
+
+#define PKTBUF_POOL(name) PKTBUF_POOL_##name##_t
+
+#define PKTBUF_PoolInit(name, p, headroom)    PKTBUF_PoolInit_##name##_(p, headroom)
+
+#define PKTBUF_Alloc(p)                       _PKTBUF_Alloc(&(p)->pool)
+#define PKTBUF_Clone(pkt, p)                  _PKTBUF_Clone(pkt, &(p)->pool)
+#define PKTBUF_Slice(pkt, p, offset, len)     _PKTBUF_Slice(pkt, &(p)->pool, offset, len)
+
+#endif /* PKTBUF_H_ */
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2015 Jason Schmidlapp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef POOL_HPP_
+#define POOL_HPP_
+
+/*
+ * C++ counterpart of DECLARE_MEMPOOL.  The pool holds N slots inline (so it can be
+ * static like the C version) threaded on a free list from list.h.  Objects are
+ * constructed in place by make(), which returns a move-only handle; when the handle is
+ * destroyed (or reset) the object is destroyed and its slot goes back on the free list.
+ *
+ * cde::pool<Connection, 64> conns;
+ *
+ * auto conn = conns.make(fd, addr);      // empty handle if the pool is exhausted
+ * if (conn)
+ *     conn->start();
+ *
+ * Like MEMPOOL this is not thread safe, and the pool must outlive every handle.
+ * Requires C++17.
+ */
+
+#include <cstddef>
+#include <new>
+#include <utility>
+
+#include "list.h"
+
+namespace cde {
+
+template <typename T, std::size_t N>
+class pool {
+	struct slot {
+		LIST_node_t node;    /* must stay first, free list entries are cast back to slots */
+		alignas(T) unsigned char bytes[sizeof(T)];
+	};
+
+public:
+	class handle {
+	public:
+		handle() = default;
+		handle(const handle &) = delete;
+		handle &operator=(const handle &) = delete;
+
+		handle(handle &&other) noexcept
+			: pool_(std::exchange(other.pool_, nullptr)), slot_(std::exchange(other.slot_, nullptr))
+		{
+		}
+
+		handle &operator=(handle &&other) noexcept
+		{
+			if (this != &other) {
+				reset();
+				pool_ = std::exchange(other.pool_, nullptr);
+				slot_ = std::exchange(other.slot_, nullptr);
+			}
+			return *this;
+		}
+
+		~handle() { reset(); }
+
+		T *get() const { return slot_ ? std::launder(reinterpret_cast<T *>(slot_->bytes)) : nullptr; }
+		T *operator->() const { return get(); }
+		T &operator*() const { return *get(); }
+		explicit operator bool() const { return slot_ != nullptr; }
+
+		/* Destroys the object and returns its slot to the pool */
+		void reset()
+		{
+			if (slot_) {
+				get()->~T();
+				pool_->release_slot(slot_);
+				slot_ = nullptr;
+				pool_ = nullptr;
+			}
+		}
+
+	private:
+		friend class pool;
+
+		handle(pool *owner, slot *s) : pool_(owner), slot_(s) {}
+
+		pool *pool_ = nullptr;
+		slot *slot_ = nullptr;
+	};
+
+	pool()
+	{
+		LIST_Init(&free_list_);
+		for (std::size_t i = 0; i < N; i++)
+			LIST_Add(&free_list_, &slots_[i].node);
+	}
+
+	pool(const pool &) = delete;
+	pool &operator=(const pool &) = delete;
+
+	static constexpr std::size_t capacity() { return N; }
+	std::size_t available() const { return available_; }
+
+	template <typename... Args>
+	handle make(Args &&...args)
+	{
+		slot *s;
+
+		if (LIST_Empty(&free_list_))
+			return handle();
+
+		s = reinterpret_cast<slot *>(free_list_.next);
+		::new (s->bytes) T(std::forward<Args>(args)...);
+
+		/* Only unlink once construction has succeeded */
+		LIST_Del(s);
+		available_--;
+		return handle(this, s);
+	}
+
+private:
+	void release_slot(slot *s)
+	{
+		LIST_Add(&free_list_, &s->node);
+		available_++;
+	}
+
+	LIST_node_t free_list_;
+	std::size_t available_ = N;
+	slot slots_[N];
+};
+
+} // namespace cde
+
+#endif // POOL_HPP_
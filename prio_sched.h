@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2015 Jason Schmidlapp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef PRIO_SCHED_H_
+#define PRIO_SCHED_H_
+
+/*
+ * Multi-class scheduler over FIFOs.  A scheduler owns numClasses static FIFOs (see
+ * DECLARE_STATIC_FIFO) of classSize entries each and picks the class to dequeue from
+ * according to one of two policies:
+ *
+ * PSCHED_STRICT - always the lowest numbered non-empty class (class 0 is the highest
+ *                 priority).  Lower classes can be starved.
+ * PSCHED_WDRR   - weighted deficit round robin.  When the scheduler moves to a class it
+ *                 grants that class weight[class] entries of credit; the class is served
+ *                 until the credit is used up or it runs empty, then the next non-empty
+ *                 class gets its turn.  Every entry costs one unit of credit, so the
+ *                 weights are relative shares of entries dequeued under load.
+ *
+ * A bitmap of non-empty classes is kept up to date on every enqueue/dequeue, so finding
+ * the next class is a single find-first-set instead of a scan of the FIFOs.  This limits
+ * numClasses to 32.
+ *
+ * Per class counters (enqueued, dequeued, and rejected because the class was full) are
+ * always kept.
+ *
+ * DECLARE_PRIO_SCHED(Packet_t *, egress, 4, 256)
+ * PSCHED(egress) sched;
+ * static const unsigned weights[4] = { 8, 4, 2, 1 };
+ *
+ * PSCHED_Init(egress, &sched, PSCHED_WDRR, weights);   // weights unused (may be NULL)
+ *                                                      // for PSCHED_STRICT
+ * PSCHED_Enqueue(egress, &sched, cls, pkt);            // 0, or -ENOBUFS if cls is full
+ * PSCHED_Dequeue(egress, &sched, &pkt);                // 0, or -EAGAIN if all are empty
+ *
+ * Like DECLARE_FIFO, a scheduler is not thread safe.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <errno.h>
+
+#include "fifo.h"
+
+typedef enum {
+	PSCHED_STRICT,
+	PSCHED_WDRR
+} PSCHED_Policy_t;
+
+typedef struct {
+	uint64_t enqueued;
+	uint64_t dequeued;
+	uint64_t rejected;
+} PSCHED_ClassStats_t;
+
+/* Index of the lowest set bit; mask must be non-zero */
+#if defined(__GNUC__)
+#define PSCHED_FFS(mask) ((unsigned) __builtin_ctz(mask))
+#else
+static inline unsigned PSCHED_FFS(uint32_t mask)
+{
+	unsigned i = 0;
+	while (!(mask & 1)) {
+		mask >>= 1;
+		i++;
+	}
+	return i;
+}
+#endif
+
+#define PSCHED_Init(name, sched, policy, weights) PSCHED_Init_##name##_(sched, policy, weights)
+#define PSCHED_Enqueue(name, sched, cls, data)    PSCHED_Enqueue_##name##_(sched, cls, data)
+#define PSCHED_Dequeue(name, sched, pdata)        PSCHED_Dequeue_##name##_(sched, pdata)
+#define PSCHED_IsEmpty(name, sched)               PSCHED_IsEmpty_##name##_(sched)
+#define PSCHED_ClassSize(name, sched, cls)        PSCHED_ClassSize_##name##_(sched, cls)
+#define PSCHED_Stats(name, sched, cls)            (&(sched)->stats[cls])
+
+#define PSCHED(name) PSCHED_##name##_t
+
+#define DECLARE_PRIO_SCHED(type, name, numClasses, classSize)                              \
+DECLARE_STATIC_FIFO(type, PSCHED_##name, classSize)                                        \
+                                                                                           \
+typedef char PSCHED_##name##_check_t[((numClasses) > 0 && (numClasses) <= 32) ? 1 : -1];   \
+                                                                                           \
+typedef struct {                                                                           \
+	uint32_t            nonEmpty;                                                          \
+	PSCHED_Policy_t     policy;                                                            \
+	unsigned            current;                                                           \
+	unsigned            weight[numClasses];                                                \
+	unsigned            deficit[numClasses];                                               \
+	PSCHED_ClassStats_t stats[numClasses];                                                 \
+	FIFO(PSCHED_##name) classes[numClasses];                                               \
+} PSCHED_##name##_t;                                                                       \
+                                                                                           \
+static inline int PSCHED_Init_##name##_(PSCHED_##name##_t *sched, PSCHED_Policy_t policy,  \
+                                        const unsigned *weights)                           \
+{                                                                                          \
+	unsigned i;                                                                            \
+	if ((sched == NULL) || ((policy == PSCHED_WDRR) && (weights == NULL)))                 \
+		return -EINVAL;                                                                    \
+	sched->nonEmpty = 0;                                                                   \
+	sched->policy = policy;                                                                \
+	sched->current = 0;                                                                    \
+	for (i=0; i<(numClasses); i++) {                                                       \
+		if ((policy == PSCHED_WDRR) && (weights[i] == 0))                                  \
+			return -EINVAL;                                                                \
+		sched->weight[i] = (policy == PSCHED_WDRR) ? weights[i] : 1;                       \
+		sched->deficit[i] = 0;                                                             \
+		sched->stats[i].enqueued = 0;                                                      \
+		sched->stats[i].dequeued = 0;                                                      \
+		sched->stats[i].rejected = 0;                                                      \
+		FIFO_InitStatic(PSCHED_##name, &sched->classes[i]);                                \
+	}                                                                                      \
+	/* The first round starts at class 0, so it is granted its credit up front */          \
+	sched->deficit[0] = sched->weight[0];                                                  \
+	return 0;                                                                              \
+}                                                                                          \
+                                                                                           \
+static inline int PSCHED_Enqueue_##name##_(PSCHED_##name##_t *sched, unsigned cls, type data) \
+{                                                                                          \
+	if (cls >= (numClasses))                                                               \
+		return -EINVAL;                                                                    \
+	if (FIFO_IsFull(PSCHED_##name, &sched->classes[cls])) {                                \
+		sched->stats[cls].rejected++;                                                      \
+		return -ENOBUFS;                                                                   \
+	}                                                                                      \
+	FIFO_Write(PSCHED_##name, &sched->classes[cls], data);                                 \
+	sched->nonEmpty |= (uint32_t) 1 << cls;                                                \
+	sched->stats[cls].enqueued++;                                                          \
+	return 0;                                                                              \
+}                                                                                          \
+                                                                                           \
+static inline int PSCHED_Dequeue_##name##_(PSCHED_##name##_t *sched, type *data)           \
+{                                                                                          \
+	unsigned cls;                                                                          \
+	if (sched->nonEmpty == 0)                                                              \
+		return -EAGAIN;                                                                    \
+	if (sched->policy == PSCHED_STRICT) {                                                  \
+		cls = PSCHED_FFS(sched->nonEmpty);                                                 \
+	}                                                                                      \
+	else {                                                                                 \
+		cls = sched->current;                                                              \
+		if (!(sched->nonEmpty & ((uint32_t) 1 << cls)) || (sched->deficit[cls] == 0)) {    \
+			/* Next non-empty class after the current one, wrapping round */               \
+			uint32_t later = (cls >= 31) ? 0 : sched->nonEmpty & ~(((uint32_t) 2 << cls) - 1); \
+			cls = PSCHED_FFS(later ? later : sched->nonEmpty);                             \
+			sched->deficit[cls] = sched->weight[cls];                                      \
+			sched->current = cls;                                                          \
+		}                                                                                  \
+		sched->deficit[cls]--;                                                             \
+	}                                                                                      \
+	*data = FIFO_Read(PSCHED_##name, &sched->classes[cls]);                                \
+	sched->stats[cls].dequeued++;                                                          \
+	if (FIFO_IsEmpty(PSCHED_##name, &sched->classes[cls])) {                               \
+		sched->nonEmpty &= ~((uint32_t) 1 << cls);                                         \
+		/* An emptied class forfeits its remaining credit, as in DRR */                    \
+		sched->deficit[cls] = 0;                                                           \
+	}                                                                                      \
+	return 0;                                                                              \
+}                                                                                          \
+                                                                                           \
+static inline int PSCHED_IsEmpty_##name##_(PSCHED_##name##_t *sched)                       \
+{                                                                                          \
+	return (sched->nonEmpty == 0);                                                         \
+}                                                                                          \
+                                                                                           \
+static inline size_t PSCHED_ClassSize_##name##_(PSCHED_##name##_t *sched, unsigned cls)    \
+{                                                                                          \
+	return FIFO_Size(PSCHED_##name, &sched->classes[cls]);                                 \
+}
+
+#endif // PRIO_SCHED_H_
@@ -34,9 +34,33 @@
  * The code doesn't do any checking that these conditions are met; bad things will
  * happen if they aren't.
  *
+ * The producer only ever writes produce_count and the consumer only ever writes
+ * consume_count.  Each side publishes its counter with a release store after touching
+ * the slot and reads the other side's counter with an acquire load, so the FIFO may be
+ * shared between two threads.
+ *
  */
 
 #include <stddef.h>
+#include <errno.h>
+
+#include "fifo_stats.h"
+
+#if defined(__GNUC__)
+#define SFIFO_LOAD_ACQUIRE(p)     __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define SFIFO_LOAD_RELAXED(p)     __atomic_load_n(p, __ATOMIC_RELAXED)
+#define SFIFO_STORE_RELEASE(p, v) __atomic_store_n(p, v, __ATOMIC_RELEASE)
+#define SFIFO_STORE_RELAXED(p, v) __atomic_store_n(p, v, __ATOMIC_RELAXED)
+#define SFIFO_FENCE_ACQUIRE()     __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#define SFIFO_FENCE_RELEASE()     __atomic_thread_fence(__ATOMIC_RELEASE)
+#else
+#define SFIFO_LOAD_ACQUIRE(p)     (*(volatile size_t *) (p))
+#define SFIFO_LOAD_RELAXED(p)     (*(volatile size_t *) (p))
+#define SFIFO_STORE_RELEASE(p, v) (*(volatile size_t *) (p) = (v))
+#define SFIFO_STORE_RELAXED(p, v) (*(volatile size_t *) (p) = (v))
+#define SFIFO_FENCE_ACQUIRE()     do { } while (0)
+#define SFIFO_FENCE_RELEASE()     do { } while (0)
+#endif
 
 #define SFIFO_Init(name, fifo)    SFIFO_Init_##name##_(fifo)
 #define SFIFO_Get(name, fifo)     SFIFO_Get_##name##_(fifo)
@@ -44,16 +68,24 @@
 #define SFIFO_Push(name, fifo,data)    SFIFO_Push_##name##_(fifo, data)
 #define SFIFO_IsEmpty(name, fifo) SFIFO_IsEmpty_##name##_(fifo)
 #define SFIFO_IsFull(name, fifo)  SFIFO_IsFull_##name##_(fifo)
+#define SFIFO_Size(name, fifo)    SFIFO_Size_##name##_(fifo)
+#define SFIFO_GetAt(name, fifo, index)  SFIFO_GetAt_##name##_(fifo, index)
+#define SFIFO_PopN(name, fifo, num)     SFIFO_PopN_##name##_(fifo, num)
+#define SFIFO_TryPop(name, fifo, pdata) SFIFO_TryPop_##name##_(fifo, pdata)
+#define SFIFO_Dropped(name, fifo)       SFIFO_Dropped_##name##_(fifo)
+#define SFIFO_StatsSnapshot(name, fifo, stats) SFIFO_StatsSnapshot_##name##_(fifo, stats)
 
 #define SFIFO(name) SFIFO_##name##_t
 
-#define MOD2(a,b) (a & (b-1))
+#define MOD2(a,b) ((a) & ((b)-1))
 
 #define DECLARE_SIMPLE_FIFO(type, name, size)                                \
 typedef struct {                                                             \
 	size_t produce_count;                                                    \
 	size_t consume_count;                                                    \
 	type   buffer[size];                                                     \
+	FIFO_STATS_FIELDS                                                        \
+	FIFO_STATS_STAMP_FIELDS(size)                                            \
 } SFIFO_##name##_t;                                                          \
                                                                              \
 static inline int SFIFO_Init_##name##_(SFIFO_##name##_t *fifo)               \
@@ -62,9 +94,15 @@ static inline int SFIFO_Init_##name##_(SFIFO_##name##_t *fifo)               \
 		return -1;                                                           \
 	fifo->produce_count = 0;                                                 \
 	fifo->consume_count = 0;                                                 \
+	FIFO_STATS_RESET(&fifo->stats);                                          \
 	return 0;                                                                \
 }                                                                            \
                                                                              \
+static inline int SFIFO_StatsSnapshot_##name##_(SFIFO_##name##_t *fifo, FIFO_Stats_t *stats) \
+{                                                                            \
+	return FIFO_STATS_SNAPSHOT(fifo, stats);                                 \
+}                                                                            \
+                                                                             \
 static inline type SFIFO_Get_##name##_(SFIFO_##name##_t *fifo)               \
 {                                                                            \
 	return fifo->buffer[MOD2(fifo->consume_count, size)];                    \
@@ -72,27 +110,171 @@ static inline type SFIFO_Get_##name##_(SFIFO_##name##_t *fifo)               \
                                                                              \
 static inline type SFIFO_Pop_##name##_(SFIFO_##name##_t *fifo)               \
 {                                                                            \
-	type data = fifo->buffer[MOD2(fifo->consume_count, size)];               \
-	/* Memory barrier ? */                                                   \
-	++fifo->consume_count;                                                   \
+	size_t count = fifo->consume_count;                                      \
+	type data = fifo->buffer[MOD2(count, size)];                             \
+	FIFO_STATS_ADD_LATENCY(&fifo->stats, fifo->stamps, MOD2(count, size));   \
+	SFIFO_STORE_RELEASE(&fifo->consume_count, count + 1);                    \
+	FIFO_STATS_DEQUEUE(&fifo->stats,                                         \
+	                   SFIFO_LOAD_ACQUIRE(&fifo->produce_count) - (count + 1)); \
 	return data;                                                             \
 }                                                                            \
                                                                              \
 static inline void SFIFO_Push_##name##_(SFIFO_##name##_t *fifo, type data)   \
 {                                                                            \
-	fifo->buffer[MOD2(fifo->produce_count, size)] = data;                    \
-	/* Memory barrier ? */                                                   \
-	++fifo->produce_count;                                                   \
+	size_t count = fifo->produce_count;                                      \
+	fifo->buffer[MOD2(count, size)] = data;                                  \
+	FIFO_STATS_STAMP(fifo->stamps, MOD2(count, size));                       \
+	/* Sample first: once published, the entry may be consumed at once */    \
+	FIFO_STATS_ENQUEUE(&fifo->stats,                                         \
+	                   count + 1 - SFIFO_LOAD_ACQUIRE(&fifo->consume_count), size); \
+	SFIFO_STORE_RELEASE(&fifo->produce_count, count + 1);                    \
 }                                                                            \
                                                                              \
 static inline int SFIFO_IsFull_##name##_(SFIFO_##name##_t *fifo)             \
 {                                                                            \
-	return ((fifo->produce_count - fifo->consume_count) == size);            \
+	return ((fifo->produce_count -                                           \
+	         SFIFO_LOAD_ACQUIRE(&fifo->consume_count)) == size);             \
 }                                                                            \
                                                                              \
 static inline int SFIFO_IsEmpty_##name##_(SFIFO_##name##_t *fifo)            \
 {                                                                            \
-	return ((fifo->produce_count - fifo->consume_count) == 0);               \
+	return ((SFIFO_LOAD_ACQUIRE(&fifo->produce_count) -                      \
+	         fifo->consume_count) == 0);                                     \
+}                                                                            \
+                                                                             \
+/* Number of entries; a lower bound from the consumer (the producer may add  \
+ * more) and an upper bound from the producer (the consumer may remove more) \
+ */                                                                          \
+static inline size_t SFIFO_Size_##name##_(SFIFO_##name##_t *fifo)            \
+{                                                                            \
+	size_t consumed = SFIFO_LOAD_ACQUIRE(&fifo->consume_count);              \
+	return (SFIFO_LOAD_ACQUIRE(&fifo->produce_count) - consumed);            \
+}                                                                            \
+                                                                             \
+/* Consumer side: peek at the index'th entry (must be < SFIFO_Size) */       \
+static inline type SFIFO_GetAt_##name##_(SFIFO_##name##_t *fifo, size_t index) \
+{                                                                            \
+	return fifo->buffer[MOD2(fifo->consume_count + index, size)];            \
+}                                                                            \
+                                                                             \
+/* Consumer side: release num entries at once after a batch of SFIFO_GetAt */ \
+static inline void SFIFO_PopN_##name##_(SFIFO_##name##_t *fifo, size_t num) \
+{                                                                            \
+	size_t count = fifo->consume_count;                                      \
+	size_t i;                                                                \
+	for (i=0; i<num; i++)                                                    \
+		FIFO_STATS_ADD_LATENCY(&fifo->stats, fifo->stamps, MOD2(count + i, size)); \
+	SFIFO_STORE_RELEASE(&fifo->consume_count, count + num);                  \
+	FIFO_STATS_DEQUEUE(&fifo->stats,                                         \
+	                   SFIFO_LOAD_ACQUIRE(&fifo->produce_count) - (count + num)); \
+}
+
+/*
+ * Overwrite-on-full variant, for telemetry and logging where losing old entries is
+ * preferable to stalling the producer.  The API is the same as above except that:
+ *
+ * - SFIFO_Push never fails and never checks for space; when the FIFO is full the
+ *   oldest entry is overwritten.  There is no SFIFO_IsFull.
+ * - Entries are read with SFIFO_TryPop(name, fifo, &data), which returns 0 on success
+ *   or -EAGAIN if the FIFO is empty.  There is no SFIFO_Get/SFIFO_Pop.
+ * - SFIFO_Dropped returns the number of entries that were overwritten before the
+ *   consumer could read them.
+ *
+ * Each slot carries a sequence number (2*position+1 while being written, 2*position+2
+ * once complete), so a reader running concurrently with the writer can tell that the
+ * slot it copied was overwritten underneath it, instead of returning torn data.  The
+ * reader then skips ahead to the oldest entry that is still intact.
+ *
+ * With FIFO_STATS (see fifo_stats.h) occupancy counters are kept, but latency is not
+ * tracked for this variant.
+ */
+#define DECLARE_OVERWRITE_SIMPLE_FIFO(type, name, size)                      \
+typedef struct {                                                             \
+	size_t seq;                                                              \
+	type   data;                                                             \
+} SFIFO_##name##_slot_t;                                                     \
+                                                                             \
+typedef struct {                                                             \
+	size_t produce_count;                                                    \
+	size_t consume_count;                                                    \
+	size_t dropped;                                                          \
+	SFIFO_##name##_slot_t buffer[size];                                      \
+	FIFO_STATS_FIELDS                                                        \
+} SFIFO_##name##_t;                                                          \
+                                                                             \
+static inline int SFIFO_Init_##name##_(SFIFO_##name##_t *fifo)               \
+{                                                                            \
+	size_t i;                                                                \
+	if (!fifo)                                                               \
+		return -1;                                                           \
+	fifo->produce_count = 0;                                                 \
+	fifo->consume_count = 0;                                                 \
+	fifo->dropped = 0;                                                       \
+	for (i=0; i<size; i++)                                                   \
+		fifo->buffer[i].seq = 0;                                             \
+	FIFO_STATS_RESET(&fifo->stats);                                          \
+	return 0;                                                                \
+}                                                                            \
+                                                                             \
+static inline int SFIFO_StatsSnapshot_##name##_(SFIFO_##name##_t *fifo, FIFO_Stats_t *stats) \
+{                                                                            \
+	return FIFO_STATS_SNAPSHOT(fifo, stats);                                 \
+}                                                                            \
+                                                                             \
+static inline void SFIFO_Push_##name##_(SFIFO_##name##_t *fifo, type data)   \
+{                                                                            \
+	size_t count = fifo->produce_count;                                      \
+	SFIFO_##name##_slot_t *slot = &fifo->buffer[MOD2(count, size)];          \
+	SFIFO_STORE_RELAXED(&slot->seq, 2*count + 1);                            \
+	SFIFO_FENCE_RELEASE();                                                   \
+	slot->data = data;                                                       \
+	SFIFO_STORE_RELEASE(&slot->seq, 2*count + 2);                            \
+	FIFO_STATS_ENQUEUE(&fifo->stats,                                         \
+	                   count + 1 - SFIFO_LOAD_ACQUIRE(&fifo->consume_count), size); \
+	SFIFO_STORE_RELEASE(&fifo->produce_count, count + 1);                    \
+}                                                                            \
+                                                                             \
+static inline int SFIFO_TryPop_##name##_(SFIFO_##name##_t *fifo, type *data) \
+{                                                                            \
+	size_t count = fifo->consume_count;                                      \
+	for (;;) {                                                               \
+		size_t produced = SFIFO_LOAD_ACQUIRE(&fifo->produce_count);          \
+		SFIFO_##name##_slot_t *slot;                                         \
+		size_t seq;                                                          \
+		if (produced == count) {                                             \
+			SFIFO_STORE_RELEASE(&fifo->consume_count, count);                \
+			return -EAGAIN;                                                  \
+		}                                                                    \
+		if (produced - count > size) {                                       \
+			/* Lapped: skip to the oldest entry that may still be intact */  \
+			fifo->dropped += produced - size - count;                        \
+			count = produced - size;                                         \
+		}                                                                    \
+		slot = &fifo->buffer[MOD2(count, size)];                             \
+		seq = SFIFO_LOAD_ACQUIRE(&slot->seq);                                \
+		if (seq == 2*count + 2) {                                            \
+			*data = slot->data;                                              \
+			SFIFO_FENCE_ACQUIRE();                                           \
+			if (SFIFO_LOAD_RELAXED(&slot->seq) == seq) {                     \
+				SFIFO_STORE_RELEASE(&fifo->consume_count, count + 1);        \
+				FIFO_STATS_DEQUEUE(&fifo->stats, produced - (count + 1));    \
+				return 0;                                                    \
+			}                                                                \
+		}                                                                    \
+		/* The writer is overwriting this slot right now */                  \
+		fifo->dropped++;                                                     \
+		count++;                                                             \
+	}                                                                        \
+}                                                                            \
+                                                                             \
+static inline int SFIFO_IsEmpty_##name##_(SFIFO_##name##_t *fifo)            \
+{                                                                            \
+	return (SFIFO_LOAD_ACQUIRE(&fifo->produce_count) == fifo->consume_count); \
+}                                                                            \
+                                                                             \
+static inline size_t SFIFO_Dropped_##name##_(SFIFO_##name##_t *fifo)         \
+{                                                                            \
+	return fifo->dropped;                                                    \
 }
 
 #endif // SIMPLE_FIFO_H_
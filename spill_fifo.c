@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2015 Jason Schmidlapp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "spill_fifo.h"
+
+static void SPILL_SegmentPath(SPILL_Store_t *store, uint64_t seq, char *path)
+{
+	snprintf(path, SPILL_PATH_MAX + 24, "%s.%llu", store->pathPrefix, (unsigned long long) seq);
+}
+
+/*
+ * New segments get their blocks allocated up front.  A sparse file (ftruncate) would
+ * only run out of space when a store through the mapping faults in a page, and that
+ * is reported as SIGBUS rather than as an error from SPILL_Write.
+ */
+static int SPILL_Map(SPILL_Store_t *store, uint64_t seq, int create, uint8_t **mapOut)
+{
+	char path[SPILL_PATH_MAX + 24];
+	size_t len = store->elemSize * store->segmentEntries;
+	void *map;
+	int fd, result;
+
+	SPILL_SegmentPath(store, seq, path);
+
+	fd = open(path, create ? (O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC) : (O_RDONLY | O_CLOEXEC), 0600);
+	if (fd < 0)
+		return -errno;
+
+	if (create) {
+		/* Returns the error number, it doesn't set errno */
+		result = posix_fallocate(fd, 0, len);
+		if (result != 0) {
+			close(fd);
+			unlink(path);
+			return -result;
+		}
+	}
+
+	map = mmap(NULL, len, create ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, fd, 0);
+	result = (map == MAP_FAILED) ? -errno : 0;
+	close(fd);
+
+	if (result != 0) {
+		if (create)
+			unlink(path);
+		return result;
+	}
+
+	madvise(map, len, MADV_SEQUENTIAL);
+	*mapOut = map;
+	return 0;
+}
+
+static void SPILL_Unmap(SPILL_Store_t *store, uint8_t *map, uint64_t seq)
+{
+	char path[SPILL_PATH_MAX + 24];
+
+	munmap(map, store->elemSize * store->segmentEntries);
+	SPILL_SegmentPath(store, seq, path);
+	unlink(path);
+}
+
+int _SPILL_Init(SPILL_Store_t *store, const char *pathPrefix, size_t elemSize, size_t segmentEntries)
+{
+	if ((pathPrefix == NULL) || (strlen(pathPrefix) >= SPILL_PATH_MAX) || (segmentEntries == 0))
+		return -EINVAL;
+
+	memset(store, 0, sizeof(*store));
+	strcpy(store->pathPrefix, pathPrefix);
+	store->elemSize = elemSize;
+	store->segmentEntries = segmentEntries;
+	return 0;
+}
+
+int _SPILL_Append(SPILL_Store_t *store, const void *data)
+{
+	if ((store->writeMap == NULL) || (store->writePos == store->segmentEntries)) {
+		uint64_t seq = store->writeSeq;
+		uint8_t *map;
+		int result;
+
+		/* The first segment of a spill keeps seq; after that a new one is needed */
+		if (store->writeMap != NULL)
+			seq++;
+
+		result = SPILL_Map(store, seq, 1, &map);
+		if (result != 0)
+			return result;
+
+		if (store->writeMap != NULL) {
+			/* A full segment is only unmapped once it has been read back */
+			if (store->readSeq == store->writeSeq)
+				store->readMap = store->writeMap;
+			else
+				munmap(store->writeMap, store->elemSize * store->segmentEntries);
+		}
+
+		store->writeMap = map;
+		store->writeSeq = seq;
+		store->writePos = 0;
+	}
+
+	memcpy(store->writeMap + store->writePos * store->elemSize, data, store->elemSize);
+	store->writePos++;
+	store->count++;
+	store->totalSpilled++;
+	return 0;
+}
+
+int _SPILL_Take(SPILL_Store_t *store, void *data)
+{
+	uint8_t *map;
+
+	if (store->count == 0)
+		return -EAGAIN;
+
+	if (store->readSeq == store->writeSeq) {
+		map = store->writeMap;
+	}
+	else {
+		if (store->readMap == NULL) {
+			int result = SPILL_Map(store, store->readSeq, 0, &store->readMap);
+			if (result != 0)
+				return result;
+		}
+		map = store->readMap;
+	}
+
+	memcpy(data, map + store->readPos * store->elemSize, store->elemSize);
+	store->readPos++;
+	store->count--;
+
+	if ((store->readSeq != store->writeSeq) && (store->readPos == store->segmentEntries)) {
+		SPILL_Unmap(store, store->readMap, store->readSeq);
+		store->readMap = NULL;
+		store->readSeq++;
+		store->readPos = 0;
+	}
+	else if (store->count == 0) {
+		/* Caught up with the writer: the spill is over */
+		SPILL_Unmap(store, store->writeMap, store->writeSeq);
+		store->writeMap = NULL;
+		store->writeSeq++;
+		store->readSeq = store->writeSeq;
+		store->writePos = 0;
+		store->readPos = 0;
+	}
+
+	return 0;
+}
+
+void _SPILL_Close(SPILL_Store_t *store)
+{
+	char path[SPILL_PATH_MAX + 24];
+	uint64_t seq;
+
+	if (store->readMap != NULL)
+		munmap(store->readMap, store->elemSize * store->segmentEntries);
+	if (store->writeMap != NULL)
+		munmap(store->writeMap, store->elemSize * store->segmentEntries);
+
+	if (store->count != 0) {
+		for (seq=store->readSeq; seq<=store->writeSeq; seq++) {
+			SPILL_SegmentPath(store, seq, path);
+			unlink(path);
+		}
+	}
+
+	store->readMap = NULL;
+	store->writeMap = NULL;
+	store->count = 0;
+}
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2015 Jason Schmidlapp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef SPILL_FIFO_H_
+#define SPILL_FIFO_H_
+
+/*
+ * FIFO that spills to disk instead of dropping data when it fills up.  The normal path
+ * is an in-memory ring (DECLARE_STATIC_FIFO) of size entries.  When a write finds the
+ * ring full, it and every following write is appended to memory-mapped segment files
+ * until the consumer has read the spilled entries back; only then do writes go to the
+ * ring again.  Since everything in the ring is older than anything on disk, the
+ * consumer simply empties the ring and then reads the segments in order, so order is
+ * preserved and all disk access is sequential.
+ *
+ * Segments hold segmentEntries entries each and are named <pathPrefix>.<n>.  They are
+ * created on demand and deleted as soon as they have been read, so a burst costs
+ * disk space only while it lasts.  The page cache does the actual I/O; a reader that
+ * keeps up with the writer reads the pages straight back from memory.
+ *
+ * DECLARE_SPILL_FIFO(Event_t, events, 4096)
+ * SPILL_FIFO(events) evfifo;
+ *
+ * SPILL_Init(events, &evfifo, "/var/spool/app/events", 1 << 16);
+ * SPILL_Write(events, &evfifo, ev);          // 0, or -errno if the spill failed
+ * SPILL_Read(events, &evfifo, &ev);          // 0, or -EAGAIN if empty
+ * SPILL_Close(events, &evfifo);              // deletes any segments left
+ *
+ * SPILL_Size returns the total number of entries and SPILL_Spilled how many of them
+ * are on disk.  Like DECLARE_FIFO this is not thread safe.  The entries are copied to
+ * disk as raw bytes, so the type must not contain pointers that need to stay valid
+ * across a restart; segments are not meant to survive one.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <errno.h>
+
+#include "fifo.h"
+
+#ifndef SPILL_PATH_MAX
+#define SPILL_PATH_MAX 256
+#endif
+
+typedef struct {
+	char     pathPrefix[SPILL_PATH_MAX];
+	size_t   elemSize;
+	size_t   segmentEntries;
+	uint64_t writeSeq;       /* segment being appended to */
+	uint64_t readSeq;        /* segment being read from */
+	uint8_t *writeMap;
+	uint8_t *readMap;        /* only used while readSeq != writeSeq */
+	size_t   writePos;       /* entries in the write segment */
+	size_t   readPos;        /* entries consumed from the read segment */
+	uint64_t count;          /* entries on disk */
+	uint64_t totalSpilled;
+} SPILL_Store_t;
+
+int  _SPILL_Init(SPILL_Store_t *store, const char *pathPrefix, size_t elemSize, size_t segmentEntries);
+int  _SPILL_Append(SPILL_Store_t *store, const void *data);
+int  _SPILL_Take(SPILL_Store_t *store, void *data);
+void _SPILL_Close(SPILL_Store_t *store);
+
+#define SPILL_Init(name, fifo, pathPrefix, segmentEntries) SPILL_Init_##name##_(fifo, pathPrefix, segmentEntries)
+#define SPILL_Write(name, fifo, data)  SPILL_Write_##name##_(fifo, data)
+#define SPILL_Read(name, fifo, pdata)  SPILL_Read_##name##_(fifo, pdata)
+#define SPILL_Size(name, fifo)         SPILL_Size_##name##_(fifo)
+#define SPILL_Spilled(name, fifo)      ((fifo)->store.count)
+#define SPILL_Close(name, fifo)        _SPILL_Close(&(fifo)->store)
+
+#define SPILL_FIFO(name) SPILL_##name##_t
+
+#define DECLARE_SPILL_FIFO(type, name, size)                                     \
+DECLARE_STATIC_FIFO(type, SPILL_##name, size)                                    \
+                                                                                 \
+typedef struct {                                                                 \
+	FIFO(SPILL_##name) ring;                                                     \
+	SPILL_Store_t      store;                                                    \
+} SPILL_##name##_t;                                                              \
+                                                                                 \
+static inline int SPILL_Init_##name##_(SPILL_##name##_t *fifo, const char *pathPrefix, \
+                                       size_t segmentEntries)                    \
+{                                                                                \
+	if (fifo == NULL)                                                            \
+		return -EINVAL;                                                          \
+	FIFO_InitStatic(SPILL_##name, &fifo->ring);                                  \
+	return _SPILL_Init(&fifo->store, pathPrefix, sizeof(type), segmentEntries);  \
+}                                                                                \
+                                                                                 \
+static inline int SPILL_Write_##name##_(SPILL_##name##_t *fifo, type data)       \
+{                                                                                \
+	/* Once anything is on disk, newer entries must queue up behind it */        \
+	if ((fifo->store.count == 0) && !FIFO_IsFull(SPILL_##name, &fifo->ring)) {   \
+		FIFO_Write(SPILL_##name, &fifo->ring, data);                             \
+		return 0;                                                                \
+	}                                                                            \
+	return _SPILL_Append(&fifo->store, &data);                                   \
+}                                                                                \
+                                                                                 \
+static inline int SPILL_Read_##name##_(SPILL_##name##_t *fifo, type *data)       \
+{                                                                                \
+	if (!FIFO_IsEmpty(SPILL_##name, &fifo->ring)) {                              \
+		*data = FIFO_Read(SPILL_##name, &fifo->ring);                            \
+		return 0;                                                                \
+	}                                                                            \
+	return _SPILL_Take(&fifo->store, data);                                      \
+}                                                                                \
+                                                                                 \
+static inline uint64_t SPILL_Size_##name##_(SPILL_##name##_t *fifo)              \
+{                                                                                \
+	return FIFO_Size(SPILL_##name, &fifo->ring) + fifo->store.count;             \
+}
+
+#endif // SPILL_FIFO_H_
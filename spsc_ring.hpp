@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2015 Jason Schmidlapp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef SPSC_RING_HPP_
+#define SPSC_RING_HPP_
+
+/*
+ * C++ counterpart of DECLARE_SIMPLE_FIFO.  Same algorithm (free running produce and
+ * consume counters, power of two size, acquire/release publication from
+ * simple_fifo.h), but the element type is a template parameter, so it may be any type
+ * including move-only ones, and elements are constructed in place.
+ *
+ * cde::spsc_ring<Message, 1024> ring;
+ *
+ * ring.try_emplace(arg1, arg2);          // producer; false when full
+ * ring.try_push(std::move(msg));         // producer; false when full
+ *
+ * if (Message *m = ring.front()) {       // consumer; nullptr when empty
+ *     handle(*m);
+ *     ring.pop();
+ * }
+ * ring.try_pop(msg);                     // consumer; moves the oldest element out
+ *
+ * As with the C version, one thread may produce and one thread may consume.  Elements
+ * still in the ring are destroyed with it.  Requires C++17.
+ */
+
+#include <cstddef>
+#include <new>
+#include <utility>
+
+#include "simple_fifo.h"
+
+namespace cde {
+
+template <typename T, std::size_t N>
+class spsc_ring {
+	static_assert(N > 0 && (N & (N - 1)) == 0, "spsc_ring size must be a power of two");
+
+public:
+	spsc_ring() = default;
+	spsc_ring(const spsc_ring &) = delete;
+	spsc_ring &operator=(const spsc_ring &) = delete;
+
+	~spsc_ring()
+	{
+		while (front())
+			pop();
+	}
+
+	static constexpr std::size_t capacity() { return N; }
+
+	/* Exact from either side only while the other side is idle */
+	std::size_t size() const
+	{
+		return SFIFO_LOAD_ACQUIRE(&produce_count_) - SFIFO_LOAD_ACQUIRE(&consume_count_);
+	}
+
+	bool empty() const { return size() == 0; }
+	bool full() const { return size() == N; }
+
+	/* Producer side */
+
+	template <typename... Args>
+	bool try_emplace(Args &&...args)
+	{
+		std::size_t produce = SFIFO_LOAD_RELAXED(&produce_count_);
+
+		if (produce - SFIFO_LOAD_ACQUIRE(&consume_count_) == N)
+			return false;
+
+		::new (slot(produce)) T(std::forward<Args>(args)...);
+		SFIFO_STORE_RELEASE(&produce_count_, produce + 1);
+		return true;
+	}
+
+	bool try_push(const T &value) { return try_emplace(value); }
+	bool try_push(T &&value) { return try_emplace(std::move(value)); }
+
+	/* Consumer side */
+
+	T *front()
+	{
+		std::size_t consume = SFIFO_LOAD_RELAXED(&consume_count_);
+
+		if (SFIFO_LOAD_ACQUIRE(&produce_count_) == consume)
+			return nullptr;
+
+		return std::launder(reinterpret_cast<T *>(slot(consume)));
+	}
+
+	/* Destroys the oldest element; the ring must not be empty */
+	void pop()
+	{
+		std::size_t consume = SFIFO_LOAD_RELAXED(&consume_count_);
+
+		std::launder(reinterpret_cast<T *>(slot(consume)))->~T();
+		SFIFO_STORE_RELEASE(&consume_count_, consume + 1);
+	}
+
+	bool try_pop(T &out)
+	{
+		T *elem = front();
+
+		if (elem == nullptr)
+			return false;
+
+		out = std::move(*elem);
+		pop();
+		return true;
+	}
+
+private:
+	void *slot(std::size_t count) { return &buffer_[MOD2(count, N)]; }
+
+	/* Kept on separate cache lines so the two sides don't false share */
+	alignas(64) std::size_t produce_count_ = 0;
+	alignas(64) std::size_t consume_count_ = 0;
+	struct storage {
+		alignas(T) unsigned char bytes[sizeof(T)];
+	};
+	alignas(64) storage buffer_[N];
+};
+
+} // namespace cde
+
+#endif // SPSC_RING_HPP_
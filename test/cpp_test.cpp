@@ -0,0 +1,252 @@
+/*
+ * Copyright (c) 2015 Jason Schmidlapp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+extern "C" {
+#include <stddef.h>
+#include <stdarg.h>
+#include <setjmp.h>
+
+#include "cmocka/cmocka.h"
+}
+
+#include "../spsc_ring.hpp"
+#include "../pool.hpp"
+#include "../channel.hpp"
+
+namespace {
+
+/* Counts live instances so the tests can check nothing leaks or is destroyed twice */
+struct Tracked {
+	static int live;
+
+	explicit Tracked(int v) : value(v) { live++; }
+	Tracked(Tracked &&other) noexcept : value(other.value) { other.value = -1; live++; }
+	Tracked &operator=(Tracked &&other) noexcept { value = other.value; other.value = -1; return *this; }
+	Tracked(const Tracked &) = delete;
+	Tracked &operator=(const Tracked &) = delete;
+	~Tracked() { live--; }
+
+	int value;
+};
+
+int Tracked::live = 0;
+
+void test_CPP_ringMoveOnly(void **state)
+{
+	cde::spsc_ring<std::unique_ptr<int>, 4> ring;
+	std::unique_ptr<int> out;
+	int i;
+
+	static_assert(cde::spsc_ring<std::unique_ptr<int>, 4>::capacity() == 4, "constexpr capacity");
+
+	assert_true(ring.empty());
+	assert_true(ring.front() == nullptr);
+	assert_true(!ring.try_pop(out));
+
+	/* Go round twice so the counters wrap the buffer */
+	for (i=0; i<8; i++) {
+		assert_true(ring.try_push(std::make_unique<int>(i)));
+
+		if (i % 4 == 3) {
+			int j;
+
+			assert_true(ring.full());
+			assert_true(!ring.try_emplace(std::make_unique<int>(0)));
+
+			for (j=i-3; j<=i; j++) {
+				assert_true(ring.try_pop(out));
+				assert_true(*out == j);
+			}
+		}
+	}
+
+	assert_true(ring.empty());
+}
+
+void test_CPP_ringEmplace(void **state)
+{
+	{
+		cde::spsc_ring<std::pair<std::string, Tracked>, 8> ring;
+
+		assert_true(ring.try_emplace(std::piecewise_construct,
+		                             std::forward_as_tuple("first"), std::forward_as_tuple(1)));
+		assert_true(ring.try_emplace(std::piecewise_construct,
+		                             std::forward_as_tuple("second"), std::forward_as_tuple(2)));
+		assert_true(ring.size() == 2);
+		assert_true(Tracked::live == 2);
+
+		assert_true(ring.front()->first == "first");
+		assert_true(ring.front()->second.value == 1);
+		ring.pop();
+		assert_true(Tracked::live == 1);
+	}
+
+	/* Whatever was left in the ring is destroyed with it */
+	assert_true(Tracked::live == 0);
+}
+
+void test_CPP_pool(void **state)
+{
+	cde::pool<Tracked, 3> pool;
+
+	assert_true(pool.capacity() == 3);
+	assert_true(pool.available() == 3);
+
+	{
+		auto a = pool.make(1);
+		auto b = pool.make(2);
+		auto c = pool.make(3);
+		auto d = pool.make(4);
+
+		assert_true(a && b && c);
+		assert_true(!d);
+		assert_true(pool.available() == 0);
+		assert_true(Tracked::live == 3);
+		assert_true(b->value == 2);
+
+		/* Moving a handle transfers ownership without touching the object */
+		d = std::move(b);
+		assert_true(!b);
+		assert_true(d->value == 2);
+		assert_true(pool.available() == 0);
+
+		a.reset();
+		assert_true(!a);
+		assert_true(pool.available() == 1);
+		assert_true(Tracked::live == 2);
+
+		a = pool.make(5);
+		assert_true(a && (*a).value == 5);
+	}
+
+	assert_true(pool.available() == 3);
+	assert_true(Tracked::live == 0);
+}
+
+/* Minimal fire-and-forget coroutine: starts immediately, frees itself when done */
+struct detached {
+	struct promise_type {
+		detached get_return_object() { return {}; }
+		std::suspend_never initial_suspend() noexcept { return {}; }
+		std::suspend_never final_suspend() noexcept { return {}; }
+		void return_void() {}
+		void unhandled_exception() { std::terminate(); }
+	};
+};
+
+using int_channel = cde::channel<std::unique_ptr<int>, 4>;
+
+detached produce(int_channel &ch, int count, int *pushed, bool closeWhenDone)
+{
+	for (int i = 0; i < count; i++) {
+		if (!co_await ch.push(std::make_unique<int>(i)))
+			co_return;
+		(*pushed)++;
+	}
+
+	if (closeWhenDone)
+		ch.close();
+}
+
+detached consume(int_channel &ch, int limit, std::vector<int> *received, bool *finished)
+{
+	for (int i = 0; i < limit; i++) {
+		std::optional<std::unique_ptr<int>> value = co_await ch.pop();
+
+		if (!value)
+			break;
+		received->push_back(**value);
+	}
+
+	*finished = true;
+}
+
+void test_CPP_channelOrder(void **state)
+{
+	int_channel ch;
+	std::vector<int> received;
+	bool finished = false;
+	int pushed = 0;
+
+	/* The consumer suspends on the empty channel; every push then resumes it directly */
+	consume(ch, 1000, &received, &finished);
+	assert_true(!finished);
+
+	produce(ch, 100, &pushed, true);
+	assert_true(pushed == 100);
+	assert_true(finished);
+	assert_true(received.size() == 100);
+
+	for (int i = 0; i < 100; i++)
+		assert_true(received[i] == i);
+}
+
+void test_CPP_channelBackpressure(void **state)
+{
+	int_channel ch;
+	std::vector<int> received;
+	bool finished = false;
+	int pushed = 0;
+
+	/* Suspends once the ring is full */
+	produce(ch, 10, &pushed, false);
+	assert_true(pushed == 4);
+
+	/* Each pop lets the waiting push in, which then fills the ring again */
+	consume(ch, 3, &received, &finished);
+	assert_true(finished);
+	assert_true(pushed == 7);
+
+	/* Closing fails the pending push; what is buffered can still be read */
+	ch.close();
+	assert_true(pushed == 7);
+
+	finished = false;
+	consume(ch, 1000, &received, &finished);
+	assert_true(finished);
+	assert_true(received.size() == 7);
+	for (int i = 0; i < 7; i++)
+		assert_true(received[i] == i);
+}
+
+} // namespace
+
+extern "C" void run_CPP_tests(void)
+{
+	UnitTest cpp_tests[] = {
+			unit_test(test_CPP_ringMoveOnly),
+			unit_test(test_CPP_ringEmplace),
+			unit_test(test_CPP_pool),
+			unit_test(test_CPP_channelOrder),
+			unit_test(test_CPP_channelBackpressure)
+	};
+
+	run_group_tests(cpp_tests);
+}
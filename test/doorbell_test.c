@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2015 Jason Schmidlapp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stddef.h>
+#include <stdarg.h>
+#include <setjmp.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+
+#include "cmocka/cmocka.h"
+#include "../doorbell.h"
+
+#define DB_FIFO_SIZE  64
+#define DB_NUM_ITEMS  100000
+
+DECLARE_SIMPLE_FIFO(unsigned, dbtest, DB_FIFO_SIZE)
+
+static SFIFO(dbtest) dbfifo;
+static DOORBELL_t bell;
+
+static int epoll_setup(void)
+{
+	struct epoll_event ev;
+	int ep = epoll_create1(0);
+
+	ev.events = EPOLLIN;
+	ev.data.fd = DOORBELL_Fd(&bell);
+	epoll_ctl(ep, EPOLL_CTL_ADD, DOORBELL_Fd(&bell), &ev);
+	return ep;
+}
+
+void test_DOORBELL_coalesce(void **state)
+{
+	struct epoll_event ev;
+	unsigned i;
+	int ep;
+
+	assert_true(DOORBELL_Init(&bell) == 0);
+	SFIFO_Init(dbtest, &dbfifo);
+	ep = epoll_setup();
+
+	assert_true(epoll_wait(ep, &ev, 1, 0) == 0);
+
+	/* A burst of pushes rings once */
+	for (i=0; i<10; i++)
+		SFIFO_PushRing(dbtest, &dbfifo, i, &bell);
+	assert_true(bell.rings == 1);
+	assert_true(epoll_wait(ep, &ev, 1, 0) == 1);
+
+	DOORBELL_Ack(&bell);
+	assert_true(epoll_wait(ep, &ev, 1, 0) == 0);
+
+	/* Data pushed before the arm became visible is caught by the re-check */
+	for (i=0; i<10; i++)
+		assert_true(SFIFO_Pop(dbtest, &dbfifo) == i);
+	SFIFO_Push(dbtest, &dbfifo, 10);
+	assert_true(SFIFO_DoorbellArm(dbtest, &dbfifo, &bell) == 0);
+	assert_true(SFIFO_Pop(dbtest, &dbfifo) == 10);
+	assert_true(SFIFO_DoorbellArm(dbtest, &dbfifo, &bell) == 1);
+
+	/* Armed again, so the next push rings */
+	SFIFO_PushRing(dbtest, &dbfifo, 11, &bell);
+	assert_true(bell.rings == 2);
+	assert_true(epoll_wait(ep, &ev, 1, 0) == 1);
+
+	close(ep);
+	DOORBELL_Close(&bell);
+}
+
+static void *producer(void *arg)
+{
+	unsigned i;
+
+	for (i=0; i<DB_NUM_ITEMS; i++) {
+		while (SFIFO_IsFull(dbtest, &dbfifo))
+			sched_yield();
+		SFIFO_PushRing(dbtest, &dbfifo, i, &bell);
+	}
+
+	return NULL;
+}
+
+void test_DOORBELL_concurrent(void **state)
+{
+	struct epoll_event ev;
+	pthread_t thread;
+	unsigned next = 0;
+	int ep;
+
+	assert_true(DOORBELL_Init(&bell) == 0);
+	SFIFO_Init(dbtest, &dbfifo);
+	ep = epoll_setup();
+
+	pthread_create(&thread, NULL, producer, NULL);
+
+	/* A lost wakeup shows up as the epoll_wait timing out with data still to come */
+	while (next < DB_NUM_ITEMS) {
+		assert_true(epoll_wait(ep, &ev, 1, 5000) == 1);
+		DOORBELL_Ack(&bell);
+
+		do {
+			while (!SFIFO_IsEmpty(dbtest, &dbfifo))
+				assert_true(SFIFO_Pop(dbtest, &dbfifo) == next++);
+		} while (!SFIFO_DoorbellArm(dbtest, &dbfifo, &bell));
+	}
+
+	pthread_join(thread, NULL);
+
+	/* Never more than one wakeup per message */
+	assert_true(bell.rings <= DB_NUM_ITEMS);
+
+	close(ep);
+	DOORBELL_Close(&bell);
+}
+
+void run_DOORBELL_tests(void)
+{
+	UnitTest doorbell_tests[] = {
+			unit_test(test_DOORBELL_coalesce),
+			unit_test(test_DOORBELL_concurrent)
+	};
+
+	run_group_tests(doorbell_tests);
+}
@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2015 Jason Schmidlapp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stddef.h>
+#include <stdarg.h>
+#include <setjmp.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "cmocka/cmocka.h"
+#include "../fanin.h"
+
+#define FANIN_PRODUCERS   70          /* more than one bitmap word */
+#define FANIN_SIZE        64
+#define FANIN_THREADS     4
+#define FANIN_PER_THREAD  50000
+
+DECLARE_FANIN(unsigned, fantest, FANIN_PRODUCERS, FANIN_SIZE)
+
+static FANIN(fantest) fanin;
+
+#define ITEM(producer, n) (((producer) << 24) | (n))
+
+void test_FANIN_poll(void **state)
+{
+	unsigned out[256];
+	unsigned next[FANIN_PRODUCERS] = { 0 };
+	size_t num, i, total = 0;
+	unsigned n;
+
+	assert_true(FANIN_Init(fantest, &fanin) == 0);
+	assert_true(FANIN_Poll(fantest, &fanin, out, 256) == 0);
+
+	/* Producer 3 fills its FIFO, 69 (second bitmap word) pushes a few */
+	for (n=0; n<FANIN_SIZE; n++)
+		assert_true(FANIN_Push(fantest, &fanin, 3, ITEM(3, n)) == 0);
+	assert_true(FANIN_Push(fantest, &fanin, 3, 0) == -EAGAIN);
+	assert_true(FANIN_Push(fantest, &fanin, FANIN_PRODUCERS, 0) == -EINVAL);
+	for (n=0; n<5; n++)
+		assert_true(FANIN_Push(fantest, &fanin, 69, ITEM(69, n)) == 0);
+
+	/* At most FANIN_BATCH from one FIFO per visit, and no more than asked for */
+	num = FANIN_Poll(fantest, &fanin, out, 256);
+	assert_true(num == FANIN_BATCH + 5);
+
+	num += FANIN_Poll(fantest, &fanin, out + num, 10);
+	assert_true(num == FANIN_BATCH + 5 + 10);
+
+	while ((i = FANIN_Poll(fantest, &fanin, out + num, 256 - num)) != 0)
+		num += i;
+	assert_true(num == FANIN_SIZE + 5);
+
+	/* Per producer order is preserved */
+	for (i=0; i<num; i++) {
+		unsigned producer = out[i] >> 24;
+
+		assert_true((producer == 3) || (producer == 69));
+		assert_true((out[i] & 0xffffff) == next[producer]);
+		next[producer]++;
+		total++;
+	}
+
+	assert_true(total == FANIN_SIZE + 5);
+	assert_true(FANIN_Poll(fantest, &fanin, out, 256) == 0);
+}
+
+static void *producer(void *arg)
+{
+	unsigned id = (unsigned) (size_t) arg;
+	unsigned n;
+
+	for (n=0; n<FANIN_PER_THREAD; n++) {
+		while (FANIN_Push(fantest, &fanin, id, ITEM(id, n)) != 0)
+			sched_yield();
+	}
+
+	return NULL;
+}
+
+void test_FANIN_concurrent(void **state)
+{
+	/* Spread over both bitmap words */
+	static const unsigned ids[FANIN_THREADS] = { 0, 31, 64, 69 };
+	pthread_t threads[FANIN_THREADS];
+	unsigned next[FANIN_PRODUCERS] = { 0 };
+	unsigned out[FANIN_BATCH * 4];
+	size_t received = 0, bad = 0;
+	size_t i;
+
+	FANIN_Init(fantest, &fanin);
+
+	for (i=0; i<FANIN_THREADS; i++)
+		pthread_create(&threads[i], NULL, producer, (void *) (size_t) ids[i]);
+
+	/* A lost ready bit would leave entries behind and hang here */
+	while (received < FANIN_THREADS * FANIN_PER_THREAD) {
+		size_t num = FANIN_Poll(fantest, &fanin, out, FANIN_BATCH * 4);
+
+		if (num == 0)
+			sched_yield();
+
+		for (i=0; i<num; i++) {
+			unsigned id = out[i] >> 24;
+
+			if ((out[i] & 0xffffff) != next[id])
+				bad++;
+			next[id]++;
+		}
+		received += num;
+	}
+
+	for (i=0; i<FANIN_THREADS; i++)
+		pthread_join(threads[i], NULL);
+
+	assert_true(bad == 0);
+	assert_true(FANIN_Poll(fantest, &fanin, out, FANIN_BATCH * 4) == 0);
+}
+
+void run_FANIN_tests(void)
+{
+	UnitTest fanin_tests[] = {
+			unit_test(test_FANIN_poll),
+			unit_test(test_FANIN_concurrent)
+	};
+
+	run_group_tests(fanin_tests);
+}
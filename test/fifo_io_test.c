@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2015 Jason Schmidlapp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stddef.h>
+#include <stdarg.h>
+#include <setjmp.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "cmocka/cmocka.h"
+#include "../fifo_io.h"
+
+#define IO_FIFO_SIZE 64
+
+DECLARE_FIFO(uint8_t, iotest)
+DECLARE_FIFO_IO(iotest)
+
+DECLARE_SIMPLE_FIFO(uint8_t, siotest, IO_FIFO_SIZE)
+DECLARE_SIMPLE_FIFO_IO(siotest, IO_FIFO_SIZE)
+
+static uint8_t ioBuffer[IO_FIFO_SIZE];
+
+static void fill_pattern(uint8_t *data, size_t len, uint8_t start)
+{
+	size_t i;
+
+	for (i=0; i<len; i++)
+		data[i] = start + i;
+}
+
+void test_FIFO_IO_readWrite(void **state)
+{
+	int i, in[2], out[2];
+	uint8_t data[IO_FIFO_SIZE], check[IO_FIFO_SIZE];
+	ssize_t num;
+	FIFO(iotest) fifo;
+	int result = FIFO_Init(iotest, &fifo, IO_FIFO_SIZE, ioBuffer);
+
+	assert_true(result == 0);
+	assert_true(pipe(in) == 0);
+	assert_true(pipe(out) == 0);
+
+	/* Move the indices so both transfers wrap around the end of the buffer */
+	for (i=0; i<40; i++) {
+		FIFO_Write(iotest, &fifo, 0);
+	}
+	FIFO_Remove(iotest, &fifo, 40);
+
+	fill_pattern(data, sizeof(data), 7);
+	assert_true(write(in[1], data, 50) == 50);
+
+	num = FIFO_ReadFd(iotest, &fifo, in[0]);
+
+	assert_true(num == 50);
+	assert_true(FIFO_Size(iotest, &fifo) == 50);
+
+	/* Only the remaining space is requested from the descriptor */
+	assert_true(write(in[1], data + 50, 14) == 14);
+	assert_true(write(in[1], data, 10) == 10);
+
+	num = FIFO_ReadFd(iotest, &fifo, in[0]);
+
+	assert_true(num == 14);
+	assert_true(FIFO_IsFull(iotest, &fifo) == 1);
+	assert_true(FIFO_ReadFd(iotest, &fifo, in[0]) == -ENOBUFS);
+
+	num = FIFO_WriteFd(iotest, &fifo, out[1]);
+
+	assert_true(num == IO_FIFO_SIZE);
+	assert_true(FIFO_IsEmpty(iotest, &fifo) == 1);
+	assert_true(read(out[0], check, sizeof(check)) == IO_FIFO_SIZE);
+	assert_true(memcmp(data, check, IO_FIFO_SIZE) == 0);
+
+	assert_true(FIFO_WriteFd(iotest, &fifo, out[1]) == 0);
+
+	/* End of file */
+	close(in[1]);
+	num = FIFO_ReadFd(iotest, &fifo, in[0]);
+	assert_true(num == 10);
+	num = FIFO_ReadFd(iotest, &fifo, in[0]);
+	assert_true(num == 0);
+
+	assert_true(FIFO_WriteFd(iotest, &fifo, -1) == -EBADF);
+
+	close(in[0]);
+	close(out[0]);
+	close(out[1]);
+}
+
+void test_SFIFO_IO_readWrite(void **state)
+{
+	int i, in[2], out[2];
+	uint8_t data[IO_FIFO_SIZE], check[IO_FIFO_SIZE];
+	ssize_t num;
+	SFIFO(siotest) fifo;
+	int result = SFIFO_Init(siotest, &fifo);
+
+	assert_true(result == 0);
+	assert_true(pipe(in) == 0);
+	assert_true(pipe(out) == 0);
+
+	for (i=0; i<40; i++) {
+		SFIFO_Push(siotest, &fifo, 0);
+	}
+	SFIFO_PopN(siotest, &fifo, 40);
+
+	fill_pattern(data, sizeof(data), 3);
+	assert_true(write(in[1], data, IO_FIFO_SIZE) == IO_FIFO_SIZE);
+
+	num = SFIFO_ReadFd(siotest, &fifo, in[0]);
+
+	assert_true(num == IO_FIFO_SIZE);
+	assert_true(SFIFO_IsFull(siotest, &fifo) == 1);
+	assert_true(SFIFO_ReadFd(siotest, &fifo, in[0]) == -ENOBUFS);
+	assert_true(SFIFO_Pop(siotest, &fifo) == 3);
+
+	num = SFIFO_WriteFd(siotest, &fifo, out[1]);
+
+	assert_true(num == IO_FIFO_SIZE - 1);
+	assert_true(SFIFO_IsEmpty(siotest, &fifo) == 1);
+	assert_true(read(out[0], check, sizeof(check)) == IO_FIFO_SIZE - 1);
+	assert_true(memcmp(data + 1, check, IO_FIFO_SIZE - 1) == 0);
+
+	close(in[0]);
+	close(in[1]);
+	close(out[0]);
+	close(out[1]);
+}
+
+void run_FIFO_IO_tests(void)
+{
+	UnitTest fifo_io_tests[] = {
+			unit_test(test_FIFO_IO_readWrite),
+			unit_test(test_SFIFO_IO_readWrite)
+	};
+
+	run_group_tests(fifo_io_tests);
+}
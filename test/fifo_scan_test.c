@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2015 Jason Schmidlapp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stddef.h>
+#include <stdarg.h>
+#include <setjmp.h>
+#include <string.h>
+#include <errno.h>
+
+#include "cmocka/cmocka.h"
+#include "../fifo_scan.h"
+
+#define SCAN_FIFO_SIZE 200
+
+DECLARE_FIFO(uint8_t, scantest)
+DECLARE_FIFO_SCAN(scantest)
+
+static uint8_t scanBuffer[SCAN_FIFO_SIZE];
+
+/* Fills the FIFO with 'a's so the data starts at readIndex and wraps round the end */
+static void setup_wrapped(FIFO(scantest) *fifo, size_t readIndex, size_t count)
+{
+	size_t i;
+
+	FIFO_Init(scantest, fifo, SCAN_FIFO_SIZE, scanBuffer);
+	for (i=0; i<readIndex; i++)
+		FIFO_Write(scantest, fifo, 'x');
+	FIFO_Pop(scantest, fifo, readIndex);
+
+	for (i=0; i<count; i++)
+		FIFO_Write(scantest, fifo, 'a');
+}
+
+/* Sets the byte at offset (from the oldest byte) */
+static void poke(FIFO(scantest) *fifo, size_t offset, uint8_t byte)
+{
+	scanBuffer[(fifo->readIndex + offset) % SCAN_FIFO_SIZE] = byte;
+}
+
+static void check_find(FIFO_ScanImpl_t impl)
+{
+	static const uint8_t set[] = { '\r', '\n', ';' };
+	FIFO(scantest) fifo;
+	size_t offset;
+
+	if (FIFO_ScanSelect(impl) != 0)
+		return;
+
+	/* Every match position, in both spans and across the SIMD block boundaries */
+	for (offset=0; offset<180; offset++) {
+		setup_wrapped(&fifo, 150, 180);
+		assert_true(FIFO_FindByte(scantest, &fifo, 0, '\n') == -ENOENT);
+
+		poke(&fifo, offset, '\n');
+		assert_true(FIFO_FindByte(scantest, &fifo, 0, '\n') == (ssize_t) offset);
+		assert_true(FIFO_FindAny(scantest, &fifo, 0, set, sizeof(set)) == (ssize_t) offset);
+		assert_true(FIFO_FindByte(scantest, &fifo, offset, '\n') == (ssize_t) offset);
+		assert_true(FIFO_FindByte(scantest, &fifo, offset + 1, '\n') == -ENOENT);
+	}
+
+	/* The earliest of several set members wins */
+	setup_wrapped(&fifo, 190, 100);
+	poke(&fifo, 70, '\n');
+	poke(&fifo, 40, ';');
+	poke(&fifo, 5, 'z');
+	assert_true(FIFO_FindAny(scantest, &fifo, 0, set, sizeof(set)) == 40);
+	assert_true(FIFO_FindAny(scantest, &fifo, 41, set, sizeof(set)) == 70);
+	assert_true(FIFO_FindAny(scantest, &fifo, 0, set, 0) == -EINVAL);
+	assert_true(FIFO_FindAny(scantest, &fifo, 0, set, FIFO_SCAN_MAX_SET + 1) == -EINVAL);
+
+	/* Bytes outside the data don't match */
+	scanBuffer[(fifo.readIndex + 100) % SCAN_FIFO_SIZE] = ';';
+	assert_true(FIFO_FindByte(scantest, &fifo, 71, ';') == -ENOENT);
+	assert_true(FIFO_FindByte(scantest, &fifo, 100, 'a') == -ENOENT);
+}
+
+void test_FIFO_SCAN_find(void **state)
+{
+	check_find(FIFO_SCAN_SCALAR);
+	check_find(FIFO_SCAN_SSE2);
+	check_find(FIFO_SCAN_AVX2);
+	assert_true(FIFO_ScanSelect(FIFO_SCAN_AUTO) == 0);
+}
+
+void test_FIFO_SCAN_peek(void **state)
+{
+	FIFO(scantest) fifo;
+	uint8_t data[16];
+	size_t i;
+
+	setup_wrapped(&fifo, 195, 20);
+	for (i=0; i<20; i++)
+		poke(&fifo, i, 'A' + i);
+
+	/* Straddles the end of the buffer */
+	assert_true(FIFO_PeekAt(scantest, &fifo, 2, data, 6) == 0);
+	assert_true(memcmp(data, "CDEFGH", 6) == 0);
+
+	assert_true(FIFO_PeekAt(scantest, &fifo, 14, data, 6) == 0);
+	assert_true(memcmp(data, "OPQRST", 6) == 0);
+	assert_true(FIFO_PeekAt(scantest, &fifo, 15, data, 6) == -ERANGE);
+	assert_true(FIFO_PeekAt(scantest, &fifo, 21, data, 0) == -ERANGE);
+
+	/* Nothing was consumed */
+	assert_true(FIFO_Size(scantest, &fifo) == 20);
+}
+
+void run_FIFO_SCAN_tests(void)
+{
+	UnitTest fifo_scan_tests[] = {
+			unit_test(test_FIFO_SCAN_find),
+			unit_test(test_FIFO_SCAN_peek)
+	};
+
+	run_group_tests(fifo_scan_tests);
+}
@@ -0,0 +1,371 @@
+/*
+ * Copyright (c) 2015 Jason Schmidlapp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#define FIFO_STATS
+#define FIFO_STATS_LATENCY
+
+#include <stddef.h>
+#include <stdarg.h>
+#include <setjmp.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "cmocka/cmocka.h"
+#include "../fifo.h"
+#include "../simple_fifo.h"
+#include "../fifo_io.h"
+
+#define STATS_FIFO_SIZE 16
+
+DECLARE_FIFO(int, stats)
+DECLARE_STATIC_FIFO(int, fstats, STATS_FIFO_SIZE)
+DECLARE_SIMPLE_FIFO(int, sstats, STATS_FIFO_SIZE)
+DECLARE_OVERWRITE_SIMPLE_FIFO(int, ostats, STATS_FIFO_SIZE)
+DECLARE_FIFO(uint8_t, iostats)
+DECLARE_FIFO_IO(iostats)
+DECLARE_STATIC_FIFO(uint8_t, fiostats, STATS_FIFO_SIZE)
+DECLARE_FIFO_IO(fiostats)
+DECLARE_SIMPLE_FIFO(uint8_t, siostats, STATS_FIFO_SIZE)
+DECLARE_SIMPLE_FIFO_IO(siostats, STATS_FIFO_SIZE)
+
+#define NUM_CONCURRENT 100000
+
+static int statsBuffer[STATS_FIFO_SIZE];
+static uint8_t ioStatsBuffer[STATS_FIFO_SIZE];
+static uint64_t stampBuffer[STATS_FIFO_SIZE];
+
+void test_FIFO_STATS_occupancy(void **state)
+{
+	int i;
+	FIFO(stats) fifo;
+	FIFO_Stats_t snapshot;
+	int result = FIFO_Init(stats, &fifo, STATS_FIFO_SIZE, statsBuffer);
+
+	assert_true(result == 0);
+
+	for (i=0; i<STATS_FIFO_SIZE; i++) {
+		FIFO_Write(stats, &fifo, i);
+	}
+
+	for (i=0; i<STATS_FIFO_SIZE; i++) {
+		FIFO_Read(stats, &fifo);
+	}
+
+	for (i=0; i<4; i++) {
+		FIFO_Write(stats, &fifo, i);
+	}
+
+	result = FIFO_StatsSnapshot(stats, &fifo, &snapshot);
+
+	assert_true(result == 0);
+	assert_true(snapshot.highWater == STATS_FIFO_SIZE);
+	assert_true(snapshot.fullEvents == 1);
+	assert_true(snapshot.emptyEvents == 1);
+
+	/* 20 writes: occupancies 1..16 then 1..4, two per bucket plus the second run */
+	assert_true(snapshot.histogram[0] == 4);
+	assert_true(snapshot.histogram[1] == 4);
+	for (i=2; i<FIFO_STATS_BUCKETS; i++) {
+		assert_true(snapshot.histogram[i] == 2);
+	}
+
+	/* No timestamp buffer attached */
+	assert_true(snapshot.latencyCount == 0);
+}
+
+void test_FIFO_STATS_latency(void **state)
+{
+	int i;
+	FIFO(stats) fifo;
+	FIFO_Stats_t snapshot;
+	int result = FIFO_Init(stats, &fifo, STATS_FIFO_SIZE, statsBuffer);
+
+	assert_true(result == 0);
+
+	result = FIFO_StatsAttach(stats, &fifo, stampBuffer);
+
+	assert_true(result == 0);
+
+	for (i=0; i<10; i++) {
+		FIFO_Write(stats, &fifo, i);
+	}
+
+	for (i=0; i<10; i++) {
+		FIFO_Read(stats, &fifo);
+	}
+
+	FIFO_StatsSnapshot(stats, &fifo, &snapshot);
+
+	assert_true(snapshot.latencyCount == 10);
+	assert_true(snapshot.latencyMax <= snapshot.latencyTotal);
+}
+
+void test_FIFO_STATS_static(void **state)
+{
+	int i;
+	int data[STATS_FIFO_SIZE] = { 0 };
+	FIFO(fstats) fifo;
+	FIFO_Stats_t snapshot;
+	int result = FIFO_InitStatic(fstats, &fifo);
+
+	assert_true(result == 0);
+
+	FIFO_WriteBulk(fstats, &fifo, data, STATS_FIFO_SIZE);
+
+	for (i=0; i<4; i++) {
+		FIFO_Read(fstats, &fifo);
+	}
+
+	FIFO_ReadBulk(fstats, &fifo, data, STATS_FIFO_SIZE);
+
+	FIFO_StatsSnapshot(fstats, &fifo, &snapshot);
+
+	assert_true(snapshot.highWater == STATS_FIFO_SIZE);
+	assert_true(snapshot.fullEvents == 1);
+	assert_true(snapshot.emptyEvents == 1);
+	assert_true(snapshot.latencyCount == STATS_FIFO_SIZE);
+}
+
+/* FIFO_Remove updates the stats the same way on both kinds of FIFO */
+void test_FIFO_STATS_remove(void **state)
+{
+	int i;
+	FIFO(stats) fifo;
+	FIFO(fstats) ffifo;
+	FIFO_Stats_t snapshot, fsnapshot;
+	int result = FIFO_Init(stats, &fifo, STATS_FIFO_SIZE, statsBuffer);
+
+	assert_true(result == 0);
+
+	FIFO_StatsAttach(stats, &fifo, stampBuffer);
+	FIFO_InitStatic(fstats, &ffifo);
+
+	for (i=0; i<10; i++) {
+		FIFO_Write(stats, &fifo, i);
+		FIFO_Write(fstats, &ffifo, i);
+	}
+
+	FIFO_Remove(stats, &fifo, 0);
+	FIFO_Remove(fstats, &ffifo, 0);
+	FIFO_Remove(stats, &fifo, 4);
+	FIFO_Remove(fstats, &ffifo, 4);
+	FIFO_Remove(stats, &fifo, 6);
+	FIFO_Remove(fstats, &ffifo, 6);
+
+	FIFO_StatsSnapshot(stats, &fifo, &snapshot);
+	FIFO_StatsSnapshot(fstats, &ffifo, &fsnapshot);
+
+	assert_true(snapshot.latencyCount == 10);
+	assert_true(fsnapshot.latencyCount == 10);
+	assert_true(snapshot.emptyEvents == 1);
+	assert_true(fsnapshot.emptyEvents == 1);
+	assert_true(snapshot.highWater == fsnapshot.highWater);
+}
+
+void test_SFIFO_STATS(void **state)
+{
+	int i;
+	SFIFO(sstats) fifo;
+	FIFO_Stats_t snapshot;
+	int result = SFIFO_Init(sstats, &fifo);
+
+	assert_true(result == 0);
+
+	for (i=0; i<STATS_FIFO_SIZE; i++) {
+		SFIFO_Push(sstats, &fifo, i);
+	}
+
+	for (i=0; i<8; i++) {
+		SFIFO_Pop(sstats, &fifo);
+	}
+
+	SFIFO_PopN(sstats, &fifo, 8);
+
+	result = SFIFO_StatsSnapshot(sstats, &fifo, &snapshot);
+
+	assert_true(result == 0);
+	assert_true(snapshot.highWater == STATS_FIFO_SIZE);
+	assert_true(snapshot.fullEvents == 1);
+	assert_true(snapshot.emptyEvents == 1);
+	assert_true(snapshot.latencyCount == STATS_FIFO_SIZE);
+}
+
+/* Slots filled by FIFO_ReadFd must be stamped, or reads measure against stale stamps */
+void test_FIFO_STATS_readFd(void **state)
+{
+	int i, fds[2];
+	uint8_t data[STATS_FIFO_SIZE] = { 0 };
+	uint64_t start;
+	FIFO(iostats) fifo;
+	FIFO(fiostats) ffifo;
+	SFIFO(siostats) sfifo;
+	FIFO_Stats_t snapshot;
+	int result = FIFO_Init(iostats, &fifo, STATS_FIFO_SIZE, ioStatsBuffer);
+
+	assert_true(result == 0);
+
+	memset(stampBuffer, 0, sizeof(stampBuffer));
+	FIFO_StatsAttach(iostats, &fifo, stampBuffer);
+	FIFO_InitStatic(fiostats, &ffifo);
+	memset(ffifo.stamps, 0, sizeof(ffifo.stamps));
+
+	result = pipe(fds);
+
+	assert_true(result == 0);
+
+	start = FIFO_STATS_Now();
+
+	assert_true(write(fds[1], data, 10) == 10);
+	assert_true(FIFO_ReadFd(iostats, &fifo, fds[0]) == 10);
+	assert_true(write(fds[1], data, 10) == 10);
+	assert_true(FIFO_ReadFd(fiostats, &ffifo, fds[0]) == 10);
+
+	for (i=0; i<10; i++) {
+		FIFO_Read(iostats, &fifo);
+		FIFO_Read(fiostats, &ffifo);
+	}
+
+	FIFO_StatsSnapshot(iostats, &fifo, &snapshot);
+
+	assert_true(snapshot.latencyCount == 10);
+	assert_true(snapshot.latencyMax <= FIFO_STATS_Now() - start);
+
+	FIFO_StatsSnapshot(fiostats, &ffifo, &snapshot);
+
+	assert_true(snapshot.latencyCount == 10);
+	assert_true(snapshot.latencyMax <= FIFO_STATS_Now() - start);
+
+	/* Simple FIFO: ReadFd stamps and counts as a write, WriteFd counts as a read */
+	SFIFO_Init(siostats, &sfifo);
+	memset(sfifo.stamps, 0, sizeof(sfifo.stamps));
+	start = FIFO_STATS_Now();
+
+	assert_true(write(fds[1], data, STATS_FIFO_SIZE) == STATS_FIFO_SIZE);
+	assert_true(SFIFO_ReadFd(siostats, &sfifo, fds[0]) == STATS_FIFO_SIZE);
+
+	for (i=0; i<6; i++)
+		SFIFO_Pop(siostats, &sfifo);
+	SFIFO_PopN(siostats, &sfifo, STATS_FIFO_SIZE - 6);
+
+	SFIFO_StatsSnapshot(siostats, &sfifo, &snapshot);
+
+	assert_true(snapshot.latencyCount == STATS_FIFO_SIZE);
+	assert_true(snapshot.latencyMax <= FIFO_STATS_Now() - start);
+	assert_true(snapshot.highWater == STATS_FIFO_SIZE);
+	assert_true(snapshot.fullEvents == 1);
+	assert_true(snapshot.histogram[FIFO_STATS_BUCKETS - 1] == 1);
+	assert_true(snapshot.emptyEvents == 1);
+
+	assert_true(write(fds[1], data, 10) == 10);
+	assert_true(SFIFO_ReadFd(siostats, &sfifo, fds[0]) == 10);
+	assert_true(SFIFO_WriteFd(siostats, &sfifo, fds[1]) == 10);
+
+	SFIFO_StatsSnapshot(siostats, &sfifo, &snapshot);
+
+	assert_true(snapshot.emptyEvents == 2);
+	assert_true(SFIFO_IsEmpty(siostats, &sfifo) == 1);
+
+	close(fds[0]);
+	close(fds[1]);
+}
+
+static SFIFO(sstats) concurrentFifo;
+static SFIFO(ostats) concurrentOverwrite;
+
+static void *concurrent_producer(void *arg)
+{
+	int i;
+
+	for (i=0; i<NUM_CONCURRENT; i++) {
+		while (SFIFO_IsFull(sstats, &concurrentFifo))
+			;
+		SFIFO_Push(sstats, &concurrentFifo, i);
+		SFIFO_Push(ostats, &concurrentOverwrite, i);
+	}
+
+	return NULL;
+}
+
+static uint64_t histogram_total(const FIFO_Stats_t *stats)
+{
+	uint64_t total = 0;
+	int i;
+
+	for (i=0; i<FIFO_STATS_BUCKETS; i++)
+		total += stats->histogram[i];
+
+	return total;
+}
+
+/* The consumer races every push, so occupancy samples must still stay in range */
+void test_SFIFO_STATS_concurrent(void **state)
+{
+	pthread_t thread;
+	FIFO_Stats_t snapshot;
+	int i, data;
+
+	SFIFO_Init(sstats, &concurrentFifo);
+	SFIFO_Init(ostats, &concurrentOverwrite);
+
+	pthread_create(&thread, NULL, concurrent_producer, NULL);
+
+	for (i=0; i<NUM_CONCURRENT; i++) {
+		while (SFIFO_IsEmpty(sstats, &concurrentFifo))
+			;
+		assert_true(SFIFO_Pop(sstats, &concurrentFifo) == i);
+		SFIFO_TryPop(ostats, &concurrentOverwrite, &data);
+	}
+
+	pthread_join(thread, NULL);
+
+	SFIFO_StatsSnapshot(sstats, &concurrentFifo, &snapshot);
+
+	assert_true(snapshot.highWater >= 1);
+	assert_true(snapshot.highWater <= STATS_FIFO_SIZE);
+	assert_true(histogram_total(&snapshot) == NUM_CONCURRENT);
+	assert_true(snapshot.latencyCount == NUM_CONCURRENT);
+
+	SFIFO_StatsSnapshot(ostats, &concurrentOverwrite, &snapshot);
+
+	assert_true(snapshot.highWater >= 1);
+	assert_true(snapshot.highWater <= STATS_FIFO_SIZE);
+	assert_true(histogram_total(&snapshot) == NUM_CONCURRENT);
+}
+
+void run_FIFO_STATS_tests(void)
+{
+	UnitTest fifo_stats_tests[] = {
+			unit_test(test_FIFO_STATS_occupancy),
+			unit_test(test_FIFO_STATS_latency),
+			unit_test(test_FIFO_STATS_static),
+			unit_test(test_FIFO_STATS_remove),
+			unit_test(test_SFIFO_STATS),
+			unit_test(test_FIFO_STATS_readFd),
+			unit_test(test_SFIFO_STATS_concurrent)
+	};
+
+	run_group_tests(fifo_stats_tests);
+}
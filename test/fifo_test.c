@@ -26,6 +26,7 @@
 #include <stdlib.h>
 #include <errno.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "cmocka/cmocka.h"
 #include "../fifo.h"
@@ -34,9 +35,11 @@
 uint8_t workingBuffer[WORKING_BUFFER_SIZE];
 
 DECLARE_FIFO(uint8_t, unittest)
+DECLARE_STATIC_FIFO(uint8_t, unitstatic, WORKING_BUFFER_SIZE)
 
 // TODO: why can't this be called fifo?
 FIFO(unittest) testfifo;
+FIFO(unitstatic) staticfifo;
 
 void test_FIFO_readWrite(void **state)
 {
@@ -235,6 +238,178 @@ void test_FIFO_getPointer(void **state)
 	assert_true(len == 60);
 }
 
+void test_FIFO_overwrite(void **state)
+{
+	int i;
+	int result = FIFO_Init(unittest, &testfifo, WORKING_BUFFER_SIZE, workingBuffer);
+
+	assert_true(result == 0);
+
+	for (i=0; i<WORKING_BUFFER_SIZE+10; i++) {
+		FIFO_WriteOverwrite(unittest, &testfifo, i);
+	}
+
+	assert_true(FIFO_IsFull(unittest, &testfifo) == 1);
+	assert_true(FIFO_Size(unittest, &testfifo) == WORKING_BUFFER_SIZE);
+	assert_true(FIFO_Dropped(unittest, &testfifo) == 10);
+
+	for (i=0; i<WORKING_BUFFER_SIZE; i++) {
+		uint32_t val = FIFO_Read(unittest, &testfifo);
+
+		assert_true(val == i+10);
+	}
+
+	assert_true(FIFO_IsEmpty(unittest, &testfifo) == 1);
+}
+
+void test_FIFO_static(void **state)
+{
+	int i;
+	uint8_t *ptr;
+	size_t len;
+	int result = FIFO_InitStatic(unitstatic, &staticfifo);
+
+	assert_true(result == 0);
+	assert_true(FIFO_IsEmpty(unitstatic, &staticfifo) == 1);
+	assert_true(FIFO_Space(unitstatic, &staticfifo) == WORKING_BUFFER_SIZE);
+
+	/* Write/read enough data to cause pointers to wrap around */
+	for (i=0; i<80; i++) {
+		FIFO_Write(unitstatic, &staticfifo, i);
+	}
+
+	for (i=0; i<40; i++) {
+		uint8_t val = FIFO_Read(unitstatic, &staticfifo);
+		assert_true(val == i);
+	}
+
+	for (i=80; i<120; i++) {
+		FIFO_Write(unitstatic, &staticfifo, i);
+	}
+
+	assert_true(FIFO_Size(unitstatic, &staticfifo) == 80);
+
+	FIFO_GetPointer(unitstatic, &staticfifo, &ptr, &len);
+
+	assert_true(len == 60);
+	assert_true(ptr[0] == 40);
+
+	FIFO_Pop(unitstatic, &staticfifo, 60);
+
+	assert_true(FIFO_Size(unitstatic, &staticfifo) == 20);
+	assert_true(FIFO_Read(unitstatic, &staticfifo) == 100);
+
+	for (i=0; i<WORKING_BUFFER_SIZE; i++) {
+		FIFO_WriteOverwrite(unitstatic, &staticfifo, i);
+	}
+
+	assert_true(FIFO_IsFull(unitstatic, &staticfifo) == 1);
+	assert_true(FIFO_Dropped(unitstatic, &staticfifo) == 19);
+}
+
+void test_FIFO_bulk(void **state)
+{
+	int i;
+	uint8_t in[WORKING_BUFFER_SIZE], out[WORKING_BUFFER_SIZE];
+	size_t num;
+	int result = FIFO_Init(unittest, &testfifo, WORKING_BUFFER_SIZE, workingBuffer);
+
+	assert_true(result == 0);
+
+	result = FIFO_InitStatic(unitstatic, &staticfifo);
+
+	assert_true(result == 0);
+
+	for (i=0; i<WORKING_BUFFER_SIZE; i++) {
+		in[i] = i;
+	}
+
+	/* Move the indices so the next bulk write wraps */
+	num = FIFO_WriteBulk(unittest, &testfifo, in, 70);
+	assert_true(num == 70);
+	num = FIFO_ReadBulk(unittest, &testfifo, out, 70);
+	assert_true(num == 70);
+
+	num = FIFO_WriteBulk(unitstatic, &staticfifo, in, 70);
+	assert_true(num == 70);
+	num = FIFO_ReadBulk(unitstatic, &staticfifo, out, 70);
+	assert_true(num == 70);
+
+	/* Only as much as fits goes in, and only as much as is there comes out */
+	num = FIFO_WriteBulk(unittest, &testfifo, in, WORKING_BUFFER_SIZE);
+	assert_true(num == WORKING_BUFFER_SIZE);
+	num = FIFO_WriteBulk(unittest, &testfifo, in, 1);
+	assert_true(num == 0);
+	num = FIFO_ReadBulk(unittest, &testfifo, out, WORKING_BUFFER_SIZE + 1);
+	assert_true(num == WORKING_BUFFER_SIZE);
+	assert_true(memcmp(in, out, WORKING_BUFFER_SIZE) == 0);
+
+	num = FIFO_WriteBulk(unitstatic, &staticfifo, in, WORKING_BUFFER_SIZE);
+	assert_true(num == WORKING_BUFFER_SIZE);
+	num = FIFO_WriteBulk(unitstatic, &staticfifo, in, 1);
+	assert_true(num == 0);
+	num = FIFO_ReadBulk(unitstatic, &staticfifo, out, WORKING_BUFFER_SIZE + 1);
+	assert_true(num == WORKING_BUFFER_SIZE);
+	assert_true(memcmp(in, out, WORKING_BUFFER_SIZE) == 0);
+	assert_true(FIFO_IsEmpty(unitstatic, &staticfifo) == 1);
+
+	/* Nothing to move: the data pointer is never touched */
+	num = FIFO_WriteBulk(unittest, &testfifo, NULL, 0);
+	assert_true(num == 0);
+	num = FIFO_ReadBulk(unittest, &testfifo, NULL, 0);
+	assert_true(num == 0);
+	num = FIFO_WriteBulk(unitstatic, &staticfifo, NULL, 0);
+	assert_true(num == 0);
+	num = FIFO_ReadBulk(unitstatic, &staticfifo, NULL, 0);
+	assert_true(num == 0);
+}
+
+/* Both kinds of FIFO report the whole contiguous run when full */
+void test_FIFO_getPointerFull(void **state)
+{
+	int i;
+	uint8_t *ptr;
+	size_t len;
+	int result = FIFO_Init(unittest, &testfifo, WORKING_BUFFER_SIZE, workingBuffer);
+
+	assert_true(result == 0);
+
+	result = FIFO_InitStatic(unitstatic, &staticfifo);
+
+	assert_true(result == 0);
+
+	for (i=0; i<WORKING_BUFFER_SIZE; i++) {
+		FIFO_Write(unittest, &testfifo, i);
+		FIFO_Write(unitstatic, &staticfifo, i);
+	}
+
+	FIFO_GetPointer(unittest, &testfifo, &ptr, &len);
+
+	assert_true(len == WORKING_BUFFER_SIZE);
+
+	FIFO_GetPointer(unitstatic, &staticfifo, &ptr, &len);
+
+	assert_true(len == WORKING_BUFFER_SIZE);
+
+	/* Full and wrapped: the run ends at the end of the buffer */
+	for (i=0; i<10; i++) {
+		FIFO_Read(unittest, &testfifo);
+		FIFO_Write(unittest, &testfifo, 0);
+		FIFO_Read(unitstatic, &staticfifo);
+		FIFO_Write(unitstatic, &staticfifo, 0);
+	}
+
+	FIFO_GetPointer(unittest, &testfifo, &ptr, &len);
+
+	assert_true(len == WORKING_BUFFER_SIZE - 10);
+	assert_true(ptr[0] == 10);
+
+	FIFO_GetPointer(unitstatic, &staticfifo, &ptr, &len);
+
+	assert_true(len == WORKING_BUFFER_SIZE - 10);
+	assert_true(ptr[0] == 10);
+}
+
 void run_FIFO_tests(void)
 {
 	UnitTest fifo_tests[] = {
@@ -244,7 +419,11 @@ void run_FIFO_tests(void)
 			unit_test(test_FIFO_readWrite),
 			unit_test(test_FIFO_size),
 			unit_test(test_FIFO_getPointer),
-			unit_test(test_FIFO_remove)
+			unit_test(test_FIFO_remove),
+			unit_test(test_FIFO_overwrite),
+			unit_test(test_FIFO_static),
+			unit_test(test_FIFO_bulk),
+			unit_test(test_FIFO_getPointerFull)
 	};
 
 	run_group_tests(fifo_tests);
@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2015 Jason Schmidlapp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stddef.h>
+#include <stdarg.h>
+#include <setjmp.h>
+#include <stdlib.h>
+#include <errno.h>
+
+#include "cmocka/cmocka.h"
+#include "../heap.h"
+
+#define HEAP_TEST_SIZE 200
+
+typedef struct {
+	int         id;
+	HEAP_node_t node;
+} Timer_t;
+
+DECLARE_HEAP(unittest, HEAP_TEST_SIZE)
+
+static HEAP(unittest) heap;
+static Timer_t timers[HEAP_TEST_SIZE + 1];
+
+static void insert_random(size_t num)
+{
+	size_t i;
+
+	srand(1);
+	for (i=0; i<num; i++) {
+		timers[i].id = i;
+		timers[i].node.key = 1 + rand() % 1000;
+		assert_true(HEAP_Insert(unittest, &heap, &timers[i].node) == 0);
+	}
+}
+
+/* Pops everything, checking the keys come out in non-decreasing order */
+static size_t drain_sorted(void)
+{
+	HEAP_node_t *node;
+	uint64_t prev = 0;
+	size_t num = 0;
+
+	while ((node = HEAP_PopMin(unittest, &heap)) != NULL) {
+		assert_true(node->key >= prev);
+		assert_true(node->index == HEAP_NOT_QUEUED);
+		prev = node->key;
+		num++;
+	}
+
+	return num;
+}
+
+void test_HEAP_insertPop(void **state)
+{
+	HEAP_Init(unittest, &heap);
+	assert_true(HEAP_IsEmpty(unittest, &heap) == 1);
+	assert_true(HEAP_PopMin(unittest, &heap) == NULL);
+	assert_true(HEAP_PeekMin(unittest, &heap) == NULL);
+
+	insert_random(HEAP_TEST_SIZE);
+	assert_true(HEAP_Size(unittest, &heap) == HEAP_TEST_SIZE);
+
+	timers[HEAP_TEST_SIZE].node.key = 0;
+	assert_true(HEAP_Insert(unittest, &heap, &timers[HEAP_TEST_SIZE].node) == -ENOBUFS);
+
+	assert_true(drain_sorted() == HEAP_TEST_SIZE);
+	assert_true(HEAP_IsEmpty(unittest, &heap) == 1);
+}
+
+void test_HEAP_decreaseKey(void **state)
+{
+	Timer_t *timer;
+
+	HEAP_Init(unittest, &heap);
+	insert_random(100);
+
+	/* Move an entry from somewhere in the middle to the front (all other keys are > 0) */
+	assert_true(HEAP_DecreaseKey(unittest, &heap, &timers[50].node, timers[50].node.key + 1) == -EINVAL);
+	assert_true(HEAP_DecreaseKey(unittest, &heap, &timers[50].node, 0) == 0);
+
+	timer = HEAP_ENTRY(HEAP_PopMin(unittest, &heap), Timer_t, node);
+	assert_true(timer->id == 50);
+
+	/* Not queued any more */
+	assert_true(HEAP_DecreaseKey(unittest, &heap, &timers[50].node, 0) == -EINVAL);
+
+	assert_true(drain_sorted() == 99);
+}
+
+void test_HEAP_remove(void **state)
+{
+	size_t removed = 0;
+	int i;
+
+	HEAP_Init(unittest, &heap);
+	insert_random(HEAP_TEST_SIZE);
+
+	/* Cancel every third timer, and the current minimum */
+	assert_true(HEAP_Remove(unittest, &heap, HEAP_PeekMin(unittest, &heap)) == 0);
+	removed++;
+	for (i=0; i<HEAP_TEST_SIZE; i+=3) {
+		if (timers[i].node.index != HEAP_NOT_QUEUED) {
+			assert_true(HEAP_Remove(unittest, &heap, &timers[i].node) == 0);
+			removed++;
+		}
+		assert_true(HEAP_Remove(unittest, &heap, &timers[i].node) == -EINVAL);
+	}
+
+	assert_true(HEAP_Size(unittest, &heap) == HEAP_TEST_SIZE - removed);
+	assert_true(drain_sorted() == HEAP_TEST_SIZE - removed);
+}
+
+void run_HEAP_tests(void)
+{
+	UnitTest heap_tests[] = {
+			unit_test(test_HEAP_insertPop),
+			unit_test(test_HEAP_decreaseKey),
+			unit_test(test_HEAP_remove)
+	};
+
+	run_group_tests(heap_tests);
+}
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2015 Jason Schmidlapp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stddef.h>
+#include <stdarg.h>
+#include <setjmp.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+
+#include "cmocka/cmocka.h"
+#include "../hugemem.h"
+
+#define HUGE_POOL_SIZE 1000
+#define HUGE_FIFO_SIZE 4096
+
+typedef struct {
+	uint32_t id;
+	uint8_t  payload[60];
+} HugeItem_t;
+
+DECLARE_MEMPOOL(HugeItem_t, HUGE_POOL_SIZE, hugepool)
+DECLARE_FIFO(uint32_t, hugefifo)
+
+void test_HUGEMEM_alloc(void **state)
+{
+	HUGEMEM_Info_t mem;
+	int result = HUGEMEM_Alloc(&mem, 100000, -1, HUGEMEM_PREFAULT);
+
+	assert_true(result == 0);
+	assert_true(mem.addr != NULL);
+	assert_true(mem.size >= 100000);
+	assert_true(mem.size % mem.pageSize == 0);
+	assert_true(mem.node == -1);
+	assert_true(mem.prefaulted == 1);
+
+	/* Whatever kind of pages were obtained, the memory must be usable */
+	memset(mem.addr, 0xa5, 100000);
+	assert_true(((uint8_t *) mem.addr)[99999] == 0xa5);
+
+	HUGEMEM_Free(&mem);
+	assert_true(mem.addr == NULL);
+
+	/* Binding may be refused (no NUMA support), which must not fail the allocation */
+	result = HUGEMEM_Alloc(&mem, 4096, 0, HUGEMEM_NO_HUGE);
+	assert_true(result == 0);
+	assert_true(mem.hugetlb == 0);
+	assert_true((mem.node == 0) || (mem.node == -1));
+	HUGEMEM_Free(&mem);
+
+	assert_true(HUGEMEM_Alloc(&mem, 0, -1, 0) == -EINVAL);
+
+	/* The fallback mapping starts on a huge page boundary so THP can back it */
+	result = HUGEMEM_Alloc(&mem, 3 * HUGEMEM_DEFAULT_HUGE_PAGE_SIZE, -1, HUGEMEM_NO_HUGE | HUGEMEM_PREFAULT);
+	assert_true(result == 0);
+	assert_true(((uintptr_t) mem.addr & (HUGEMEM_DEFAULT_HUGE_PAGE_SIZE - 1)) == 0);
+	assert_true(mem.size == 3 * HUGEMEM_DEFAULT_HUGE_PAGE_SIZE);
+	assert_true(mem.prefaulted == 1);
+	memset(mem.addr, 0x5a, mem.size);
+	HUGEMEM_Free(&mem);
+}
+
+void test_HUGEMEM_containers(void **state)
+{
+	HUGEMEM_Info_t poolMem, fifoMem;
+	MEMPOOL(hugepool) *pool = HUGEMEM_MempoolInit(hugepool, &poolMem, -1, 0);
+	FIFO(hugefifo) fifo;
+	HugeItem_t *item;
+	uint32_t i;
+
+	assert_true(pool != NULL);
+	assert_true(poolMem.size >= sizeof(MEMPOOL(hugepool)));
+	assert_true(pool->nextUnused == 0);
+
+	item = MEMPOOL_Alloc(hugepool, pool);
+	assert_true(item != NULL);
+	item->id = 42;
+	MEMPOOL_Free(hugepool, pool, item);
+
+	assert_true(HUGEMEM_FifoInit(hugefifo, &fifo, HUGE_FIFO_SIZE, &fifoMem, -1, HUGEMEM_PREFAULT) == 0);
+	assert_true(fifoMem.size >= HUGE_FIFO_SIZE * sizeof(uint32_t));
+
+	for (i=0; i<HUGE_FIFO_SIZE; i++)
+		FIFO_Write(hugefifo, &fifo, i);
+
+	assert_true(FIFO_IsFull(hugefifo, &fifo) == 1);
+
+	for (i=0; i<HUGE_FIFO_SIZE; i++)
+		assert_true(FIFO_Read(hugefifo, &fifo) == i);
+
+	HUGEMEM_Free(&fifoMem);
+	HUGEMEM_Free(&poolMem);
+
+	/* The allocation's own error comes back, not FIFO_Init's -EINVAL for a NULL buffer */
+	assert_true(HUGEMEM_FifoInit(hugefifo, &fifo, HUGE_FIFO_SIZE, (HUGEMEM_Info_t *) NULL, -1, 0) == -EINVAL);
+	assert_true(HUGEMEM_FifoInit(hugefifo, &fifo, SIZE_MAX / 8, &fifoMem, -1, HUGEMEM_NO_HUGE) == -ENOMEM);
+	assert_true(fifoMem.addr == NULL);
+}
+
+void run_HUGEMEM_tests(void)
+{
+	UnitTest hugemem_tests[] = {
+			unit_test(test_HUGEMEM_alloc),
+			unit_test(test_HUGEMEM_containers)
+	};
+
+	run_group_tests(hugemem_tests);
+}
@@ -113,12 +113,121 @@ static void test_LIST_del(void **state)
 	}
 }
 
+static void test_LIST_splice(void **state)
+{
+	int i;
+	test_entry_t entries[6];
+	LIST_node_t first, second;
+	test_entry_t *entry;
+
+	LIST_Init(&first);
+	LIST_Init(&second);
+
+	for (i=0; i<6; i++) {
+		entries[i].data = i;
+	}
+
+	/* first: 2 1 0, second: 5 4 3 */
+	for (i=0; i<3; i++) {
+		LIST_Add(&first, &entries[i]);
+		LIST_Add(&second, &entries[i+3]);
+	}
+
+	LIST_Splice(&second, &first);
+
+	assert_true(LIST_Empty(&second) == 1);
+
+	i = 5;
+	LIST_foreach(entry, &first, test_entry_t) {
+		assert_true(entry->data == i);
+		i--;
+	}
+	assert_true(i == -1);
+
+	/* Splicing an empty list is a no-op */
+	LIST_Splice(&second, &first);
+
+	i = 5;
+	LIST_foreach(entry, &first, test_entry_t) {
+		assert_true(entry->data == i);
+		i--;
+	}
+	assert_true(i == -1);
+}
+
+static void test_LIST_spliceTail(void **state)
+{
+	int i;
+	test_entry_t entries[6];
+	LIST_node_t first, second;
+	test_entry_t *entry;
+
+	LIST_Init(&first);
+	LIST_Init(&second);
+
+	for (i=0; i<6; i++) {
+		entries[i].data = i;
+	}
+
+	for (i=0; i<3; i++) {
+		LIST_Add(&first, &entries[i]);
+		LIST_Add(&second, &entries[i+3]);
+	}
+
+	/* 2 1 0 followed by 5 4 3 */
+	LIST_SpliceTail(&second, &first);
+
+	assert_true(LIST_Empty(&second) == 1);
+
+	i = 0;
+	LIST_foreach(entry, &first, test_entry_t) {
+		int expected[6] = { 2, 1, 0, 5, 4, 3 };
+		assert_true(entry->data == expected[i]);
+		i++;
+	}
+	assert_true(i == 6);
+}
+
+static void test_LIST_cutPosition(void **state)
+{
+	int i;
+	test_entry_t entries[5];
+	LIST_node_t head, cut;
+	test_entry_t *entry;
+
+	LIST_Init(&head);
+
+	for (i=0; i<5; i++) {
+		entries[i].data = i;
+		LIST_Add(&head, &entries[i]);
+	}
+
+	/* head: 4 3 2 1 0 -> cut: 4 3 2, head: 1 0 */
+	LIST_CutPosition(&cut, &head, &entries[2]);
+
+	i = 4;
+	LIST_foreach(entry, &cut, test_entry_t) {
+		assert_true(entry->data == i);
+		i--;
+	}
+	assert_true(i == 1);
+
+	LIST_foreach(entry, &head, test_entry_t) {
+		assert_true(entry->data == i);
+		i--;
+	}
+	assert_true(i == -1);
+}
+
 void run_LIST_tests(void)
 {
 	UnitTest list_tests[] = {
 			unit_test(test_LIST_empty),
 			unit_test(test_LIST_add),
-			unit_test(test_LIST_del)
+			unit_test(test_LIST_del),
+			unit_test(test_LIST_splice),
+			unit_test(test_LIST_spliceTail),
+			unit_test(test_LIST_cutPosition)
 	};
 
 	run_tests(list_tests);
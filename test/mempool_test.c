@@ -12,6 +12,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
+#include <errno.h>
 
 #include "../cmocka/cmocka.h"
 #include "../mempool.h"
@@ -77,11 +78,98 @@ static void test_MEMPOOL_free(void **state)
 	}
 }
 
+static void test_MEMPOOL_bulk(void **state)
+{
+	int i;
+	struct test *ptr;
+	struct test *burst[10];
+	int result;
+	MEMPOOL(rxdesc) pool;
+
+	MEMPOOL_Init(rxdesc, &pool);
+
+	ptr = MEMPOOL_Alloc(rxdesc, &pool);
+	assert_true(ptr != NULL);
+
+	/* Only 9 left, so asking for 10 must not allocate anything */
+	result = MEMPOOL_AllocBulk(rxdesc, &pool, burst, 10);
+	assert_true(result == -ENOMEM);
+
+	result = MEMPOOL_AllocBulk(rxdesc, &pool, burst, 9);
+	assert_true(result == 0);
+
+	for (i=0; i<9; i++) {
+		assert_true(burst[i] != NULL);
+		assert_true(burst[i] != ptr);
+		memset(burst[i], 0, sizeof(test_t));
+	}
+
+	assert_true(MEMPOOL_Alloc(rxdesc, &pool) == NULL);
+
+	burst[9] = ptr;
+	MEMPOOL_FreeBulk(rxdesc, &pool, burst, 10);
+
+	result = MEMPOOL_AllocBulk(rxdesc, &pool, burst, 10);
+	assert_true(result == 0);
+
+	MEMPOOL_FreeBulk(rxdesc, &pool, burst, 5);
+
+	for (i=0; i<5; i++) {
+		ptr = MEMPOOL_Alloc(rxdesc, &pool);
+		assert_true(ptr != NULL);
+	}
+
+	assert_true(MEMPOOL_Alloc(rxdesc, &pool) == NULL);
+}
+
+static void test_MEMPOOL_lazy(void **state)
+{
+	int i, j;
+	struct test *ptr;
+	struct test *ptr_array[10];
+	struct test *burst[10];
+	MEMPOOL(rxdesc) pool;
+
+	MEMPOOL_InitLazy(rxdesc, &pool);
+
+	/* Never used buffers are handed out in order */
+	for (i=0; i<4; i++) {
+		ptr_array[i] = MEMPOOL_Alloc(rxdesc, &pool);
+		assert_true(ptr_array[i] == &pool.bufferDescs[i].buffer);
+	}
+
+	/* A freed buffer is reused before the next untouched one */
+	MEMPOOL_Free(rxdesc, &pool, ptr_array[1]);
+	ptr = MEMPOOL_Alloc(rxdesc, &pool);
+	assert_true(ptr == ptr_array[1]);
+
+	/* Bulk: 2 from the free list plus 6 never used ones, then nothing is left */
+	MEMPOOL_Free(rxdesc, &pool, ptr_array[0]);
+	MEMPOOL_Free(rxdesc, &pool, ptr_array[3]);
+	assert_true(MEMPOOL_AllocBulk(rxdesc, &pool, burst, 9) == -ENOMEM);
+	assert_true(MEMPOOL_AllocBulk(rxdesc, &pool, burst, 8) == 0);
+	assert_true(MEMPOOL_Alloc(rxdesc, &pool) == NULL);
+
+	for (i=0; i<8; i++) {
+		memset(burst[i], 0, sizeof(test_t));
+		for (j=0; j<i; j++)
+			assert_true(burst[i] != burst[j]);
+		assert_true(burst[i] != ptr_array[1] && burst[i] != ptr_array[2]);
+	}
+
+	MEMPOOL_FreeBulk(rxdesc, &pool, burst, 8);
+	for (i=0; i<8; i++)
+		assert_true(MEMPOOL_Alloc(rxdesc, &pool) != NULL);
+	assert_true(MEMPOOL_Alloc(rxdesc, &pool) == NULL);
+}
+
 void run_MEMPOOL_tests(void)
 {
 	UnitTest mempool_tests[] = {
 			unit_test(test_MEMPOOL_alloc),
-			unit_test(test_MEMPOOL_free)
+			unit_test(test_MEMPOOL_free),
+			unit_test(test_MEMPOOL_bulk),
+			unit_test(test_MEMPOOL_lazy)
 	};
 
 	run_group_tests(mempool_tests);
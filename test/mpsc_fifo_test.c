@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2015 Jason Schmidlapp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "cmocka/cmocka.h"
+#include "../mpsc_fifo.h"
+
+#define MPSC_SIZE         16
+#define NUM_PRODUCERS     4
+#define ITEMS_PER_PRODUCER 20000
+
+DECLARE_MPSC_FIFO(unsigned, unittest, MPSC_SIZE)
+
+static MPSC(unittest) mpsc;
+
+void test_MPSC_pushPop(void **state)
+{
+	unsigned i, val = 0;
+	int result = MPSC_Init(unittest, &mpsc);
+
+	assert_true(result == 0);
+	assert_true(MPSC_IsEmpty(unittest, &mpsc) == 1);
+	assert_true(MPSC_TryPop(unittest, &mpsc, &val) == -EAGAIN);
+
+	/* Go round twice to exercise the sequence numbers of the second lap */
+	for (i=0; i<2*MPSC_SIZE; i++) {
+		result = MPSC_TryPush(unittest, &mpsc, i);
+		assert_true(result == 0);
+
+		if (i % MPSC_SIZE == MPSC_SIZE - 1) {
+			unsigned j;
+
+			assert_true(MPSC_TryPush(unittest, &mpsc, 0) == -EAGAIN);
+
+			for (j=i+1-MPSC_SIZE; j<=i; j++) {
+				result = MPSC_TryPop(unittest, &mpsc, &val);
+				assert_true(result == 0);
+				assert_true(val == j);
+			}
+		}
+	}
+
+	assert_true(MPSC_IsEmpty(unittest, &mpsc) == 1);
+}
+
+static void *producer(void *arg)
+{
+	unsigned id = (unsigned) (size_t) arg;
+	unsigned i;
+
+	/* Yield rather than spin so the test also completes on a single CPU */
+	for (i=0; i<ITEMS_PER_PRODUCER; i++)
+		while (MPSC_TryPush(unittest, &mpsc, (id << 24) | i) != 0)
+			sched_yield();
+
+	return NULL;
+}
+
+void test_MPSC_concurrent(void **state)
+{
+	pthread_t threads[NUM_PRODUCERS];
+	unsigned next[NUM_PRODUCERS] = { 0 };
+	unsigned received = 0;
+	size_t i;
+
+	MPSC_Init(unittest, &mpsc);
+
+	for (i=0; i<NUM_PRODUCERS; i++)
+		pthread_create(&threads[i], NULL, producer, (void *) i);
+
+	/* Each producer's items must arrive complete and in order */
+	while (received < NUM_PRODUCERS * ITEMS_PER_PRODUCER) {
+		unsigned val;
+
+		if (MPSC_TryPop(unittest, &mpsc, &val) == 0) {
+			unsigned id = val >> 24;
+
+			assert_true(id < NUM_PRODUCERS);
+			assert_true((val & 0xffffff) == next[id]);
+			next[id]++;
+			received++;
+		}
+		else {
+			sched_yield();
+		}
+	}
+
+	for (i=0; i<NUM_PRODUCERS; i++)
+		pthread_join(threads[i], NULL);
+
+	assert_true(MPSC_IsEmpty(unittest, &mpsc) == 1);
+}
+
+void run_MPSC_tests(void)
+{
+	UnitTest mpsc_tests[] = {
+			unit_test(test_MPSC_pushPop),
+			unit_test(test_MPSC_concurrent)
+	};
+
+	run_group_tests(mpsc_tests);
+}
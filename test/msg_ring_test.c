@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2015 Jason Schmidlapp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stddef.h>
+#include <stdarg.h>
+#include <setjmp.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "cmocka/cmocka.h"
+#include "../msg_ring.h"
+
+#define MSG_RING_SIZE 256
+#define MSG_NUM_MSGS  100000
+
+static uint8_t ringBuffer[MSG_RING_SIZE] __attribute__((aligned(8)));
+static MSGRING_t ring;
+
+/* Message n has length n % 61 and bytes n, n+1, ... */
+static size_t fill_message(uint8_t *p, unsigned n)
+{
+	size_t len = n % 61, i;
+
+	for (i=0; i<len; i++)
+		p[i] = (uint8_t) (n + i);
+
+	return len;
+}
+
+static int check_message(const uint8_t *p, size_t len, unsigned n)
+{
+	size_t i;
+
+	if (len != n % 61)
+		return 0;
+
+	for (i=0; i<len; i++) {
+		if (p[i] != (uint8_t) (n + i))
+			return 0;
+	}
+
+	return 1;
+}
+
+void test_MSGRING_basic(void **state)
+{
+	uint8_t msg[MSG_RING_SIZE];
+	const uint8_t *p;
+	uint32_t type;
+	size_t len;
+	uint8_t *w;
+
+	assert_true(MSGRING_Init(&ring, ringBuffer, 100) == -EINVAL);
+	assert_true(MSGRING_Init(&ring, ringBuffer + 4, 128) == -EINVAL);
+	assert_true(MSGRING_Init(&ring, ringBuffer, MSG_RING_SIZE) == 0);
+	assert_true(MSGRING_Peek(&ring, &len, &type) == NULL);
+
+	/* Reserve more than needed, commit less */
+	w = MSGRING_Reserve(&ring, 40);
+	assert_true(w != NULL);
+	memcpy(w, "hello", 5);
+
+	/* The pad type is reserved; a rejected commit leaves the reservation open */
+	assert_true(MSGRING_Commit(&ring, 5, MSGRING_TYPE_PAD) == -EINVAL);
+	assert_true(MSGRING_IsEmpty(&ring) == 1);
+	assert_true(MSGRING_Commit(&ring, 5, 1) == 0);
+
+	assert_true(MSGRING_Write(&ring, 2, "", 0) == 0);
+	assert_true(MSGRING_Write(&ring, 3, msg, MSGRING_MaxLen(&ring) + 1) == -EMSGSIZE);
+	assert_true(MSGRING_Write(&ring, MSGRING_TYPE_PAD, msg, 8) == -EINVAL);
+
+	p = MSGRING_Peek(&ring, &len, &type);
+	assert_true(p != NULL && len == 5 && type == 1);
+	assert_true(memcmp(p, "hello", 5) == 0);
+	MSGRING_Release(&ring);
+
+	p = MSGRING_Peek(&ring, &len, &type);
+	assert_true(p != NULL && len == 0 && type == 2);
+	MSGRING_Release(&ring);
+	assert_true(MSGRING_IsEmpty(&ring) == 1);
+}
+
+void test_MSGRING_wrap(void **state)
+{
+	uint8_t msg[MSG_RING_SIZE];
+	const uint8_t *p;
+	uint32_t type;
+	size_t len;
+
+	memset(msg, 0x5a, sizeof(msg));
+	assert_true(MSGRING_Init(&ring, ringBuffer, MSG_RING_SIZE) == 0);
+
+	/* 3 x 72 bytes leaves 40 at the end, too little for the next 72 byte message */
+	assert_true(MSGRING_Write(&ring, 1, msg, 64) == 0);
+	assert_true(MSGRING_Write(&ring, 2, msg, 64) == 0);
+	assert_true(MSGRING_Write(&ring, 3, msg, 64) == 0);
+	assert_true(MSGRING_Write(&ring, 4, msg, 64) == -ENOBUFS);
+
+	/* Freeing the first message makes room once the tail is padded out */
+	p = MSGRING_Peek(&ring, &len, &type);
+	assert_true(type == 1);
+	MSGRING_Release(&ring);
+	assert_true(MSGRING_Write(&ring, 4, msg, 64) == 0);
+
+	/* The ring is now completely full */
+	assert_true(MSGRING_Write(&ring, 5, msg, MSGRING_MaxLen(&ring)) == -ENOBUFS);
+
+	p = MSGRING_Peek(&ring, &len, &type);
+	assert_true(type == 2);
+	MSGRING_Release(&ring);
+	p = MSGRING_Peek(&ring, &len, &type);
+	assert_true(type == 3);
+	MSGRING_Release(&ring);
+
+	/* Skips the pad record; the message is contiguous at the start of the buffer */
+	p = MSGRING_Peek(&ring, &len, &type);
+	assert_true(type == 4 && len == 64);
+	assert_true(p == ringBuffer + sizeof(MSGRING_Header_t));
+	MSGRING_Release(&ring);
+
+	/* Even the largest message fits, wherever the ring has wrapped to */
+	assert_true(MSGRING_Write(&ring, 5, msg, MSGRING_MaxLen(&ring)) == 0);
+	p = MSGRING_Peek(&ring, &len, &type);
+	assert_true(type == 5 && len == MSGRING_MaxLen(&ring));
+	MSGRING_Release(&ring);
+	assert_true(MSGRING_IsEmpty(&ring) == 1);
+}
+
+static void *producer(void *arg)
+{
+	unsigned n;
+
+	for (n=0; n<MSG_NUM_MSGS; n++) {
+		uint8_t *p;
+
+		while ((p = MSGRING_Reserve(&ring, 60)) == NULL)
+			sched_yield();
+		MSGRING_Commit(&ring, fill_message(p, n), n);
+	}
+
+	return NULL;
+}
+
+void test_MSGRING_concurrent(void **state)
+{
+	pthread_t thread;
+	unsigned n = 0, bad = 0;
+
+	assert_true(MSGRING_Init(&ring, ringBuffer, MSG_RING_SIZE) == 0);
+	pthread_create(&thread, NULL, producer, NULL);
+
+	while (n < MSG_NUM_MSGS) {
+		const uint8_t *p;
+		uint32_t type;
+		size_t len;
+
+		p = MSGRING_Peek(&ring, &len, &type);
+		if (p == NULL) {
+			sched_yield();
+			continue;
+		}
+
+		if ((type != n) || !check_message(p, len, n))
+			bad++;
+		MSGRING_Release(&ring);
+		n++;
+	}
+
+	pthread_join(thread, NULL);
+	assert_true(bad == 0);
+	assert_true(MSGRING_IsEmpty(&ring) == 1);
+}
+
+void run_MSGRING_tests(void)
+{
+	UnitTest msg_ring_tests[] = {
+			unit_test(test_MSGRING_basic),
+			unit_test(test_MSGRING_wrap),
+			unit_test(test_MSGRING_concurrent)
+	};
+
+	run_group_tests(msg_ring_tests);
+}
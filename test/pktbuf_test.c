@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2015 Jason Schmidlapp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <string.h>
+#include <errno.h>
+
+#include "cmocka/cmocka.h"
+#include "../pktbuf.h"
+
+#define NUM_BUFS  8
+#define ROOM_SIZE 256
+#define HEADROOM  32
+
+DECLARE_PKTBUF_POOL(unittest, NUM_BUFS, ROOM_SIZE)
+
+static PKTBUF_POOL(unittest) pool;
+
+/* Number of buffers currently free in the pool */
+static int count_free(void)
+{
+	PKTBUF_t *bufs[NUM_BUFS];
+	int i, num = 0;
+
+	while ((num < NUM_BUFS) && ((bufs[num] = PKTBUF_Alloc(&pool)) != NULL))
+		num++;
+
+	for (i=0; i<num; i++)
+		PKTBUF_Free(bufs[i]);
+
+	return num;
+}
+
+void test_PKTBUF_alloc(void **state)
+{
+	PKTBUF_t *pkt;
+	int result;
+
+	result = PKTBUF_PoolInit(unittest, &pool, ROOM_SIZE + 1);
+
+	assert_true(result == -EINVAL);
+
+	result = PKTBUF_PoolInit(unittest, &pool, HEADROOM);
+
+	assert_true(result == 0);
+
+	pkt = PKTBUF_Alloc(&pool);
+
+	assert_true(pkt != NULL);
+	assert_true(pkt->len == 0);
+	assert_true(pkt->pktLen == 0);
+	assert_true(PKTBUF_Headroom(pkt) == HEADROOM);
+	assert_true(PKTBUF_Tailroom(pkt) == ROOM_SIZE - HEADROOM);
+	assert_true(count_free() == NUM_BUFS - 1);
+
+	PKTBUF_Free(pkt);
+
+	assert_true(count_free() == NUM_BUFS);
+}
+
+void test_PKTBUF_headTail(void **state)
+{
+	PKTBUF_t *pkt;
+	uint8_t *ptr;
+
+	PKTBUF_PoolInit(unittest, &pool, HEADROOM);
+	pkt = PKTBUF_Alloc(&pool);
+
+	ptr = PKTBUF_Append(pkt, 100);
+	assert_true(ptr == pkt->data);
+	memset(ptr, 'b', 100);
+
+	ptr = PKTBUF_Prepend(pkt, 8);
+	assert_true(ptr != NULL);
+	memset(ptr, 'h', 8);
+
+	assert_true(pkt->len == 108);
+	assert_true(pkt->pktLen == 108);
+	assert_true(PKTBUF_Headroom(pkt) == HEADROOM - 8);
+
+	assert_true(PKTBUF_Prepend(pkt, HEADROOM) == NULL);
+	assert_true(PKTBUF_Append(pkt, ROOM_SIZE) == NULL);
+
+	ptr = PKTBUF_Adj(pkt, 8);
+	assert_true(ptr[0] == 'b');
+	assert_true(pkt->pktLen == 100);
+
+	assert_true(PKTBUF_Trim(pkt, 50) == 0);
+	assert_true(pkt->pktLen == 50);
+	assert_true(PKTBUF_Trim(pkt, 51) == -EINVAL);
+
+	PKTBUF_Free(pkt);
+}
+
+void test_PKTBUF_clone(void **state)
+{
+	PKTBUF_t *pkt, *clone;
+	uint8_t *ptr;
+
+	PKTBUF_PoolInit(unittest, &pool, HEADROOM);
+	pkt = PKTBUF_Alloc(&pool);
+	ptr = PKTBUF_Append(pkt, 16);
+	memcpy(ptr, "0123456789abcdef", 16);
+
+	clone = PKTBUF_Clone(pkt, &pool);
+
+	assert_true(clone != NULL);
+	assert_true(PKTBUF_IsIndirect(clone));
+	assert_true(clone->data == pkt->data);
+	assert_true(clone->pktLen == 16);
+	assert_true(pkt->refcnt == 2);
+
+	/* Clones share the data, so they can't grow it */
+	assert_true(PKTBUF_Append(clone, 1) == NULL);
+	assert_true(PKTBUF_Prepend(clone, 1) == NULL);
+
+	/* The original's data room stays allocated until the clone is gone */
+	PKTBUF_Free(pkt);
+	assert_true(count_free() == NUM_BUFS - 2);
+	assert_true(memcmp(clone->data, "0123456789abcdef", 16) == 0);
+
+	PKTBUF_Free(clone);
+	assert_true(count_free() == NUM_BUFS);
+}
+
+void test_PKTBUF_chainSlice(void **state)
+{
+	PKTBUF_t *first, *second, *slice;
+
+	PKTBUF_PoolInit(unittest, &pool, HEADROOM);
+	first = PKTBUF_Alloc(&pool);
+	second = PKTBUF_Alloc(&pool);
+	memcpy(PKTBUF_Append(first, 10), "0123456789", 10);
+	memcpy(PKTBUF_Append(second, 10), "abcdefghij", 10);
+
+	assert_true(PKTBUF_Chain(first, second) == 0);
+	assert_true(first->numSegs == 2);
+	assert_true(first->pktLen == 20);
+
+	/* Spans both segments: "789abc" */
+	slice = PKTBUF_Slice(first, &pool, 7, 6);
+
+	assert_true(slice != NULL);
+	assert_true(slice->numSegs == 2);
+	assert_true(slice->pktLen == 6);
+	assert_true(slice->len == 3);
+	assert_true(memcmp(slice->data, "789", 3) == 0);
+	assert_true(memcmp(slice->next->data, "abc", 3) == 0);
+
+	assert_true(PKTBUF_Slice(first, &pool, 15, 6) == NULL);
+
+	PKTBUF_Free(first);
+	assert_true(count_free() == NUM_BUFS - 4);
+
+	PKTBUF_Free(slice);
+	assert_true(count_free() == NUM_BUFS);
+}
+
+void run_PKTBUF_tests(void)
+{
+	UnitTest pktbuf_tests[] = {
+			unit_test(test_PKTBUF_alloc),
+			unit_test(test_PKTBUF_headTail),
+			unit_test(test_PKTBUF_clone),
+			unit_test(test_PKTBUF_chainSlice)
+	};
+
+	run_group_tests(pktbuf_tests);
+}
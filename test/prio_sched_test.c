@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2015 Jason Schmidlapp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stddef.h>
+#include <stdarg.h>
+#include <setjmp.h>
+#include <errno.h>
+
+#include "cmocka/cmocka.h"
+#include "../prio_sched.h"
+
+#define PS_CLASSES    3
+#define PS_CLASS_SIZE 64
+
+DECLARE_PRIO_SCHED(unsigned, pstest, PS_CLASSES, PS_CLASS_SIZE)
+
+static PSCHED(pstest) sched;
+
+/* Items are tagged with their class so the dequeue order can be checked */
+#define ITEM(cls, n) (((cls) << 16) | (n))
+#define CLASS_OF(item) ((item) >> 16)
+
+void test_PSCHED_strict(void **state)
+{
+	unsigned i, val = 0;
+
+	assert_true(PSCHED_Init(pstest, &sched, PSCHED_STRICT, NULL) == 0);
+	assert_true(PSCHED_Dequeue(pstest, &sched, &val) == -EAGAIN);
+
+	for (i=0; i<4; i++) {
+		assert_true(PSCHED_Enqueue(pstest, &sched, 2, ITEM(2, i)) == 0);
+		assert_true(PSCHED_Enqueue(pstest, &sched, 1, ITEM(1, i)) == 0);
+	}
+	assert_true(PSCHED_Enqueue(pstest, &sched, PS_CLASSES, 0) == -EINVAL);
+
+	/* Class 1 drains completely, in order, before class 2 gets anything */
+	for (i=0; i<4; i++) {
+		assert_true(PSCHED_Dequeue(pstest, &sched, &val) == 0);
+		assert_true(val == ITEM(1, i));
+	}
+
+	/* A late arrival in a higher class overtakes */
+	assert_true(PSCHED_Enqueue(pstest, &sched, 0, ITEM(0, 0)) == 0);
+	assert_true(PSCHED_Dequeue(pstest, &sched, &val) == 0);
+	assert_true(val == ITEM(0, 0));
+
+	for (i=0; i<4; i++) {
+		assert_true(PSCHED_Dequeue(pstest, &sched, &val) == 0);
+		assert_true(val == ITEM(2, i));
+	}
+
+	assert_true(PSCHED_IsEmpty(pstest, &sched) == 1);
+	assert_true(PSCHED_Stats(pstest, &sched, 1)->enqueued == 4);
+	assert_true(PSCHED_Stats(pstest, &sched, 1)->dequeued == 4);
+}
+
+void test_PSCHED_full(void **state)
+{
+	unsigned i;
+
+	assert_true(PSCHED_Init(pstest, &sched, PSCHED_STRICT, NULL) == 0);
+
+	for (i=0; i<PS_CLASS_SIZE; i++)
+		assert_true(PSCHED_Enqueue(pstest, &sched, 0, i) == 0);
+
+	assert_true(PSCHED_Enqueue(pstest, &sched, 0, i) == -ENOBUFS);
+	assert_true(PSCHED_Enqueue(pstest, &sched, 1, i) == 0);
+	assert_true(PSCHED_Stats(pstest, &sched, 0)->rejected == 1);
+	assert_true(PSCHED_ClassSize(pstest, &sched, 0) == PS_CLASS_SIZE);
+	assert_true(PSCHED_ClassSize(pstest, &sched, 1) == 1);
+}
+
+void test_PSCHED_wdrr(void **state)
+{
+	static const unsigned weights[PS_CLASSES] = { 4, 2, 1 };
+	static const unsigned zeroWeight[PS_CLASSES] = { 4, 0, 1 };
+	unsigned counts[PS_CLASSES] = { 0 };
+	unsigned next[PS_CLASSES] = { 0 };
+	unsigned i, val = 0;
+
+	assert_true(PSCHED_Init(pstest, &sched, PSCHED_WDRR, NULL) == -EINVAL);
+	assert_true(PSCHED_Init(pstest, &sched, PSCHED_WDRR, zeroWeight) == -EINVAL);
+	assert_true(PSCHED_Init(pstest, &sched, PSCHED_WDRR, weights) == 0);
+
+	for (i=0; i<PS_CLASS_SIZE; i++) {
+		PSCHED_Enqueue(pstest, &sched, 0, ITEM(0, i));
+		PSCHED_Enqueue(pstest, &sched, 1, ITEM(1, i));
+		PSCHED_Enqueue(pstest, &sched, 2, ITEM(2, i));
+	}
+
+	/* The very first round starts with class 0, and serves the classes in order */
+	for (i=0; i<7; i++) {
+		static const unsigned firstRound[7] = { 0, 0, 0, 0, 1, 1, 2 };
+
+		assert_true(PSCHED_Dequeue(pstest, &sched, &val) == 0);
+		assert_true(CLASS_OF(val) == firstRound[i]);
+		assert_true((val & 0xffff) == next[CLASS_OF(val)]);
+		next[CLASS_OF(val)]++;
+		counts[CLASS_OF(val)]++;
+	}
+
+	/* While every class is backlogged, 7 dequeues are exactly one round of 4:2:1 */
+	for (i=0; i<7*8; i++) {
+		unsigned cls;
+
+		assert_true(PSCHED_Dequeue(pstest, &sched, &val) == 0);
+		cls = CLASS_OF(val);
+		assert_true((val & 0xffff) == next[cls]);
+		next[cls]++;
+		counts[cls]++;
+
+		if (i % 7 == 6) {
+			assert_true(counts[0] == 4 * (i / 7 + 2));
+			assert_true(counts[1] == 2 * (i / 7 + 2));
+			assert_true(counts[2] == 1 * (i / 7 + 2));
+		}
+	}
+
+	/* Everything still comes out, each class in FIFO order */
+	while (PSCHED_Dequeue(pstest, &sched, &val) == 0) {
+		assert_true((val & 0xffff) == next[CLASS_OF(val)]);
+		next[CLASS_OF(val)]++;
+	}
+
+	for (i=0; i<PS_CLASSES; i++)
+		assert_true(next[i] == PS_CLASS_SIZE);
+}
+
+void run_PSCHED_tests(void)
+{
+	UnitTest psched_tests[] = {
+			unit_test(test_PSCHED_strict),
+			unit_test(test_PSCHED_full),
+			unit_test(test_PSCHED_wdrr)
+	};
+
+	run_group_tests(psched_tests);
+}
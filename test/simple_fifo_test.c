@@ -26,12 +26,16 @@
 #include <setjmp.h>
 #include "cmocka.h"
 #include <errno.h>
+#include <pthread.h>
 
 #define FIFO_SIZE 8
+#define NUM_LAPPED 1000000
 
 DECLARE_SIMPLE_FIFO(int, test, FIFO_SIZE);
+DECLARE_OVERWRITE_SIMPLE_FIFO(int, lossy, FIFO_SIZE);
 
 SFIFO(test) fifo;
+SFIFO(lossy) lossyfifo;
 
 void test_SFIFO_readWrite(void **state)
 {
@@ -133,6 +137,66 @@ void test_SFIFO_wrap(void **state)
 	}
 }
 
+void test_SFIFO_overwrite(void **state)
+{
+	int i, val = 0;
+	int result = SFIFO_Init(lossy, &lossyfifo);
+
+	assert_true(result == 0);
+
+	result = SFIFO_TryPop(lossy, &lossyfifo, &val);
+
+	assert_true(result == -EAGAIN);
+
+	for (i=0; i<FIFO_SIZE+3; i++) {
+		SFIFO_Push(lossy, &lossyfifo, i);
+	}
+
+	for (i=0; i<FIFO_SIZE; i++) {
+		result = SFIFO_TryPop(lossy, &lossyfifo, &val);
+		assert_true(result == 0);
+		assert_true(val == i+3);
+	}
+
+	assert_true(SFIFO_IsEmpty(lossy, &lossyfifo) == 1);
+	assert_true(SFIFO_Dropped(lossy, &lossyfifo) == 3);
+}
+
+static void *lossy_producer(void *arg)
+{
+	int i;
+
+	for (i=0; i<NUM_LAPPED; i++) {
+		SFIFO_Push(lossy, &lossyfifo, i);
+	}
+
+	return NULL;
+}
+
+void test_SFIFO_overwriteConcurrent(void **state)
+{
+	pthread_t producer;
+	int val, last = -1;
+	size_t received = 0;
+	int result = SFIFO_Init(lossy, &lossyfifo);
+
+	assert_true(result == 0);
+
+	pthread_create(&producer, NULL, lossy_producer, NULL);
+
+	/* Whatever we get must be in order, and every entry is either read or dropped */
+	while (last != NUM_LAPPED-1) {
+		if (SFIFO_TryPop(lossy, &lossyfifo, &val) == 0) {
+			assert_true(val > last);
+			last = val;
+			received++;
+		}
+	}
+
+	pthread_join(producer, NULL);
+
+	assert_true(received + SFIFO_Dropped(lossy, &lossyfifo) == NUM_LAPPED);
+}
 
 void run_SFIFO_tests(void)
 {
@@ -142,6 +206,8 @@ void run_SFIFO_tests(void)
 			unit_test(test_SFIFO_full),
 			unit_test(test_SFIFO_readWrite),
 			unit_test(test_SFIFO_wrap),
+			unit_test(test_SFIFO_overwrite),
+			unit_test(test_SFIFO_overwriteConcurrent),
 	};
 
 	run_group_tests(sfifo_tests);
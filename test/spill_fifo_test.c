@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) 2015 Jason Schmidlapp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stddef.h>
+#include <stdarg.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/resource.h>
+
+#include "cmocka/cmocka.h"
+#include "../spill_fifo.h"
+
+#define SPILL_RING_SIZE    8
+#define SPILL_SEG_ENTRIES  16
+
+typedef struct {
+	uint32_t seq;
+	uint32_t check;
+} SpillEntry_t;
+
+DECLARE_SPILL_FIFO(SpillEntry_t, spilltest, SPILL_RING_SIZE)
+
+static SPILL_FIFO(spilltest) spill;
+static char spillDir[] = "/tmp/spill_testXXXXXX";
+static char spillPrefix[64];
+
+static int segment_exists(uint64_t seq)
+{
+	char path[128];
+
+	snprintf(path, sizeof(path), "%s.%llu", spillPrefix, (unsigned long long) seq);
+	return access(path, F_OK) == 0;
+}
+
+static void write_entries(uint32_t first, uint32_t num)
+{
+	SpillEntry_t entry;
+	uint32_t i;
+
+	for (i=first; i<first+num; i++) {
+		entry.seq = i;
+		entry.check = ~i;
+		assert_true(SPILL_Write(spilltest, &spill, entry) == 0);
+	}
+}
+
+static void read_entries(uint32_t first, uint32_t num)
+{
+	SpillEntry_t entry;
+	uint32_t i;
+
+	for (i=first; i<first+num; i++) {
+		assert_true(SPILL_Read(spilltest, &spill, &entry) == 0);
+		assert_true(entry.seq == i);
+		assert_true(entry.check == ~i);
+	}
+}
+
+void test_SPILL_inMemory(void **state)
+{
+	SpillEntry_t entry;
+
+	assert_true(mkdtemp(spillDir) != NULL);
+	snprintf(spillPrefix, sizeof(spillPrefix), "%s/seg", spillDir);
+
+	assert_true(SPILL_Init(spilltest, &spill, spillPrefix, SPILL_SEG_ENTRIES) == 0);
+	assert_true(SPILL_Read(spilltest, &spill, &entry) == -EAGAIN);
+
+	/* Up to the ring size nothing touches the disk */
+	write_entries(0, SPILL_RING_SIZE);
+	assert_true(SPILL_Spilled(spilltest, &spill) == 0);
+	assert_true(!segment_exists(0));
+
+	read_entries(0, SPILL_RING_SIZE);
+	assert_true(SPILL_Read(spilltest, &spill, &entry) == -EAGAIN);
+	SPILL_Close(spilltest, &spill);
+}
+
+void test_SPILL_overflow(void **state)
+{
+	const uint32_t burst = SPILL_RING_SIZE + 3 * SPILL_SEG_ENTRIES + 5;
+	SpillEntry_t entry;
+
+	assert_true(SPILL_Init(spilltest, &spill, spillPrefix, SPILL_SEG_ENTRIES) == 0);
+
+	/* A burst of four segments' worth beyond the ring */
+	write_entries(0, burst);
+	assert_true(SPILL_Size(spilltest, &spill) == burst);
+	assert_true(SPILL_Spilled(spilltest, &spill) == burst - SPILL_RING_SIZE);
+	assert_true(segment_exists(0) && segment_exists(3) && !segment_exists(4));
+
+	/* Draining the ring frees space, but new writes must still go behind the spill */
+	read_entries(0, SPILL_RING_SIZE);
+	write_entries(burst, 10);
+	assert_true(SPILL_Spilled(spilltest, &spill) == burst - SPILL_RING_SIZE + 10);
+
+	/* Segments are deleted as they are read */
+	read_entries(SPILL_RING_SIZE, SPILL_SEG_ENTRIES);
+	assert_true(!segment_exists(0));
+	assert_true(segment_exists(1));
+
+	read_entries(SPILL_RING_SIZE + SPILL_SEG_ENTRIES, burst + 10 - SPILL_RING_SIZE - SPILL_SEG_ENTRIES);
+	assert_true(SPILL_Read(spilltest, &spill, &entry) == -EAGAIN);
+	assert_true(SPILL_Spilled(spilltest, &spill) == 0);
+	assert_true(!segment_exists(4));
+
+	/* With the spill over, writes go back to the ring */
+	write_entries(0, 1);
+	assert_true(SPILL_Spilled(spilltest, &spill) == 0);
+	read_entries(0, 1);
+
+	SPILL_Close(spilltest, &spill);
+}
+
+/* Running out of space is an error from SPILL_Write, not a SIGBUS on a later store */
+void test_SPILL_noSpace(void **state)
+{
+	struct rlimit saved, limit;
+	SpillEntry_t entry = { 0, 0 };
+	int result;
+
+	assert_true(SPILL_Init(spilltest, &spill, spillPrefix, SPILL_SEG_ENTRIES) == 0);
+	write_entries(0, SPILL_RING_SIZE);
+
+	/* A file size limit below one segment stands in for a full disk */
+	getrlimit(RLIMIT_FSIZE, &saved);
+	limit = saved;
+	limit.rlim_cur = sizeof(SpillEntry_t) * SPILL_SEG_ENTRIES / 2;
+	signal(SIGXFSZ, SIG_IGN);
+	setrlimit(RLIMIT_FSIZE, &limit);
+
+	result = SPILL_Write(spilltest, &spill, entry);
+
+	setrlimit(RLIMIT_FSIZE, &saved);
+	signal(SIGXFSZ, SIG_DFL);
+
+	assert_true(result == -EFBIG);
+	assert_true(SPILL_Spilled(spilltest, &spill) == 0);
+	assert_true(!segment_exists(0));
+
+	/* With space back, the spill works */
+	write_entries(SPILL_RING_SIZE, 1);
+	assert_true(SPILL_Spilled(spilltest, &spill) == 1);
+	read_entries(0, SPILL_RING_SIZE + 1);
+
+	SPILL_Close(spilltest, &spill);
+}
+
+void test_SPILL_interleaved(void **state)
+{
+	uint32_t written = 0, readCount = 0;
+
+	assert_true(SPILL_Init(spilltest, &spill, spillPrefix, SPILL_SEG_ENTRIES) == 0);
+
+	/* A consumer that keeps falling behind and catching up, in and out of spilling */
+	while (written < 2000) {
+		uint32_t num = rand() % 40;
+
+		write_entries(written, num);
+		written += num;
+
+		num = rand() % 40;
+		if (num > written - readCount)
+			num = written - readCount;
+		read_entries(readCount, num);
+		readCount += num;
+	}
+
+	read_entries(readCount, written - readCount);
+	assert_true(SPILL_Size(spilltest, &spill) == 0);
+
+	/* Closing with data still spilled removes the segments */
+	write_entries(0, SPILL_RING_SIZE + SPILL_SEG_ENTRIES + 1);
+	SPILL_Close(spilltest, &spill);
+	assert_true(rmdir(spillDir) == 0);
+}
+
+void run_SPILL_tests(void)
+{
+	UnitTest spill_tests[] = {
+			unit_test(test_SPILL_inMemory),
+			unit_test(test_SPILL_overflow),
+			unit_test(test_SPILL_noSpace),
+			unit_test(test_SPILL_interleaved)
+	};
+
+	run_group_tests(spill_tests);
+}
@@ -31,6 +31,21 @@ void run_FIFO_tests(void);
 void run_MEMPOOL_tests(void);
 void run_LIST_tests(void);
 void run_SFIFO_tests(void);
+void run_TPOOL_tests(void);
+void run_FIFO_STATS_tests(void);
+void run_PKTBUF_tests(void);
+void run_FIFO_IO_tests(void);
+void run_MPSC_tests(void);
+void run_HUGEMEM_tests(void);
+void run_DOORBELL_tests(void);
+void run_PSCHED_tests(void);
+void run_TRACE_tests(void);
+void run_HEAP_tests(void);
+void run_SPILL_tests(void);
+void run_FIFO_SCAN_tests(void);
+void run_MSGRING_tests(void);
+void run_FANIN_tests(void);
+void run_CPP_tests(void);
 
 int main(void) {
 	init_tests();
@@ -38,6 +53,21 @@ int main(void) {
 	run_MEMPOOL_tests();
 	run_LIST_tests();
 	run_SFIFO_tests();
+	run_TPOOL_tests();
+	run_FIFO_STATS_tests();
+	run_PKTBUF_tests();
+	run_FIFO_IO_tests();
+	run_MPSC_tests();
+	run_HUGEMEM_tests();
+	run_DOORBELL_tests();
+	run_PSCHED_tests();
+	run_TRACE_tests();
+	run_HEAP_tests();
+	run_SPILL_tests();
+	run_FIFO_SCAN_tests();
+	run_MSGRING_tests();
+	run_FANIN_tests();
+	run_CPP_tests();
 	end_tests();
 
 	return 0;
@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2015 Jason Schmidlapp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <errno.h>
+
+#include "cmocka/cmocka.h"
+#include "../threadpool.h"
+
+#define NUM_TASKS 10000
+
+static TPOOL_t pool;
+static int counter;
+static int release;
+
+static void increment(void *arg)
+{
+	__atomic_fetch_add((int *) arg, 1, __ATOMIC_RELAXED);
+}
+
+static void block(void *arg)
+{
+	while (!__atomic_load_n((int *) arg, __ATOMIC_ACQUIRE))
+		;
+}
+
+void test_TPOOL_init(void **state)
+{
+	int result;
+
+	result = TPOOL_Init(NULL, 1, TPOOL_POLICY_ROUND_ROBIN);
+
+	assert_true(result == -EINVAL);
+
+	result = TPOOL_Init(&pool, 0, TPOOL_POLICY_ROUND_ROBIN);
+
+	assert_true(result == -EINVAL);
+
+	result = TPOOL_Init(&pool, TPOOL_MAX_WORKERS + 1, TPOOL_POLICY_ROUND_ROBIN);
+
+	assert_true(result == -EINVAL);
+
+	result = TPOOL_Init(&pool, 2, TPOOL_POLICY_ROUND_ROBIN);
+
+	assert_true(result == 0);
+
+	TPOOL_Destroy(&pool);
+}
+
+static void run_counter(TPOOL_Policy_t policy)
+{
+	int i;
+	int result = TPOOL_Init(&pool, 4, policy);
+
+	assert_true(result == 0);
+
+	counter = 0;
+
+	for (i=0; i<NUM_TASKS; i++) {
+		while ((result = TPOOL_Submit(&pool, increment, &counter)) == -EAGAIN)
+			;
+		assert_true(result == 0);
+	}
+
+	TPOOL_Wait(&pool);
+
+	assert_true(counter == NUM_TASKS);
+
+	TPOOL_Destroy(&pool);
+}
+
+void test_TPOOL_roundRobin(void **state)
+{
+	run_counter(TPOOL_POLICY_ROUND_ROBIN);
+}
+
+void test_TPOOL_leastLoaded(void **state)
+{
+	run_counter(TPOOL_POLICY_LEAST_LOADED);
+}
+
+void test_TPOOL_full(void **state)
+{
+	int i;
+	int result = TPOOL_Init(&pool, 1, TPOOL_POLICY_ROUND_ROBIN);
+
+	assert_true(result == 0);
+
+	release = 0;
+	counter = 0;
+
+	/* The blocking task keeps its slot until it returns */
+	result = TPOOL_Submit(&pool, block, &release);
+
+	assert_true(result == 0);
+
+	for (i=0; i<TPOOL_QUEUE_SIZE-1; i++) {
+		result = TPOOL_Submit(&pool, increment, &counter);
+		assert_true(result == 0);
+	}
+
+	result = TPOOL_Submit(&pool, increment, &counter);
+
+	assert_true(result == -EAGAIN);
+
+	__atomic_store_n(&release, 1, __ATOMIC_RELEASE);
+	TPOOL_Wait(&pool);
+
+	assert_true(counter == TPOOL_QUEUE_SIZE-1);
+
+	TPOOL_Destroy(&pool);
+}
+
+/* A single worker kept busy, so the submitter keeps refilling the run queue while
+ * finished descriptors are still waiting in the done queue
+ */
+void test_TPOOL_outstanding(void **state)
+{
+	int i;
+	int result = TPOOL_Init(&pool, 1, TPOOL_POLICY_ROUND_ROBIN);
+
+	assert_true(result == 0);
+
+	counter = 0;
+
+	for (i=0; i<NUM_TASKS*10; i++) {
+		while ((result = TPOOL_Submit(&pool, increment, &counter)) == -EAGAIN)
+			;
+		assert_true(result == 0);
+		assert_true(pool.workers[0].outstanding <= TPOOL_QUEUE_SIZE);
+	}
+
+	TPOOL_Wait(&pool);
+
+	assert_true(counter == NUM_TASKS*10);
+	assert_true(pool.workers[0].outstanding == 0);
+
+	TPOOL_Destroy(&pool);
+}
+
+void run_TPOOL_tests(void)
+{
+	UnitTest tpool_tests[] = {
+			unit_test(test_TPOOL_init),
+			unit_test(test_TPOOL_roundRobin),
+			unit_test(test_TPOOL_leastLoaded),
+			unit_test(test_TPOOL_full),
+			unit_test(test_TPOOL_outstanding)
+	};
+
+	run_group_tests(tpool_tests);
+}
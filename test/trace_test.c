@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2015 Jason Schmidlapp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stddef.h>
+#include <stdarg.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "cmocka/cmocka.h"
+#include "../trace.h"
+
+#define EV_TEST   7
+#define EV_WORKER 8
+
+/* Reads a dump back, returning the number of records of the named thread */
+static uint32_t read_dump(FILE *fp, const char *threadName, TRACE_Record_t *records,
+                          uint64_t *dropped)
+{
+	TRACE_FileHeader_t header;
+	uint32_t found = 0;
+	unsigned t;
+
+	rewind(fp);
+	assert_true(fread(&header, sizeof(header), 1, fp) == 1);
+	assert_true(header.magic == TRACE_MAGIC);
+	assert_true(header.version == TRACE_VERSION);
+
+	for (t=0; t<header.numThreads; t++) {
+		TRACE_ThreadHeader_t threadHeader;
+		TRACE_Record_t rec;
+		uint32_t r;
+
+		assert_true(fread(&threadHeader, sizeof(threadHeader), 1, fp) == 1);
+		for (r=0; r<threadHeader.numRecords; r++) {
+			assert_true(fread(&rec, sizeof(rec), 1, fp) == 1);
+			if (strcmp(threadHeader.name, threadName) == 0)
+				records[found++] = rec;
+		}
+
+		if (strcmp(threadHeader.name, threadName) == 0)
+			*dropped = threadHeader.dropped;
+	}
+
+	return found;
+}
+
+static void *worker(void *arg)
+{
+	unsigned i;
+
+	TRACE_ThreadInit("worker");
+	for (i=0; i<10; i++)
+		TRACE(EV_WORKER, i, 0);
+
+	return NULL;
+}
+
+void test_TRACE_recordDump(void **state)
+{
+	static TRACE_Record_t records[TRACE_RING_SIZE];
+	FILE *fp = tmpfile();
+	pthread_t thread;
+	uint64_t dropped = 0;
+	unsigned i;
+
+	/* Not registered yet, so this is ignored */
+	TRACE(EV_TEST, 99, 99);
+
+	assert_true(TRACE_ThreadInit("main") == 0);
+	for (i=0; i<100; i++)
+		TRACE(EV_TEST, i, 2*i);
+
+	pthread_create(&thread, NULL, worker, NULL);
+	pthread_join(thread, NULL);
+
+	assert_true(TRACE_Dump(fileno(fp)) == 0);
+
+	assert_true(read_dump(fp, "main", records, &dropped) == 100);
+	assert_true(dropped == 0);
+	for (i=0; i<100; i++) {
+		assert_true(records[i].event == EV_TEST);
+		assert_true(records[i].arg0 == i);
+		assert_true(records[i].arg1 == 2*i);
+		if (i > 0)
+			assert_true(records[i].tsc >= records[i-1].tsc);
+	}
+
+	assert_true(read_dump(fp, "worker", records, &dropped) == 10);
+	assert_true(records[9].arg0 == 9);
+
+	/* Records are dumped once */
+	fclose(fp);
+	fp = tmpfile();
+	assert_true(TRACE_Dump(fileno(fp)) == 0);
+	assert_true(read_dump(fp, "main", records, &dropped) == 0);
+	fclose(fp);
+}
+
+void test_TRACE_lossy(void **state)
+{
+	static TRACE_Record_t records[TRACE_RING_SIZE];
+	FILE *fp = tmpfile();
+	uint64_t dropped = 0;
+	unsigned i;
+
+	assert_true(TRACE_ThreadInit("main") == 0);
+
+	/* Overfill the ring; only the newest TRACE_RING_SIZE records survive */
+	for (i=0; i<TRACE_RING_SIZE + 100; i++)
+		TRACE(EV_TEST, i, 0);
+
+	assert_true(TRACE_Dump(fileno(fp)) == 0);
+	assert_true(read_dump(fp, "main", records, &dropped) == TRACE_RING_SIZE);
+	assert_true(dropped == 100);
+	assert_true(records[0].arg0 == 100);
+	assert_true(records[TRACE_RING_SIZE - 1].arg0 == TRACE_RING_SIZE + 99);
+
+	fclose(fp);
+}
+
+void run_TRACE_tests(void)
+{
+	UnitTest trace_tests[] = {
+			unit_test(test_TRACE_recordDump),
+			unit_test(test_TRACE_lossy)
+	};
+
+	run_group_tests(trace_tests);
+}
@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) 2015 Jason Schmidlapp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <errno.h>
+#include <sched.h>
+
+#include "threadpool.h"
+
+#if defined(__i386__) || defined(__x86_64__)
+#define TPOOL_CPU_RELAX() __builtin_ia32_pause()
+#else
+#define TPOOL_CPU_RELAX() do { } while (0)
+#endif
+
+static void *TPOOL_WorkerMain(void *arg)
+{
+	TPOOL_Worker_t *worker = arg;
+	unsigned spins = 0;
+	size_t i, num;
+
+	for (;;) {
+		num = SFIFO_Size(tpool_run, &worker->runQueue);
+
+		if (num > 0) {
+			if (num > TPOOL_BATCH_SIZE)
+				num = TPOOL_BATCH_SIZE;
+
+			for (i=0; i<num; i++) {
+				TPOOL_Task_t *task = SFIFO_GetAt(tpool_run, &worker->runQueue, i);
+
+				task->func(task->arg);
+				SFIFO_Push(tpool_done, &worker->doneQueue, task);
+			}
+
+			/* Only release the slots once the tasks have run, so an empty run
+			 * queue means the worker is idle (see TPOOL_Wait).
+			 */
+			SFIFO_PopN(tpool_run, &worker->runQueue, num);
+			spins = 0;
+			continue;
+		}
+
+		if (__atomic_load_n(&worker->stop, __ATOMIC_ACQUIRE))
+			break;
+
+		if (++spins < TPOOL_SPIN_COUNT) {
+			TPOOL_CPU_RELAX();
+			continue;
+		}
+
+		spins = 0;
+
+		pthread_mutex_lock(&worker->lock);
+		__atomic_store_n(&worker->parked, 1, __ATOMIC_RELAXED);
+		/* Pairs with the fence in TPOOL_Notify: either we see the new task or the
+		 * submitter sees parked set and signals us.
+		 */
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+		while (SFIFO_IsEmpty(tpool_run, &worker->runQueue) &&
+		       !__atomic_load_n(&worker->stop, __ATOMIC_ACQUIRE))
+			pthread_cond_wait(&worker->wake, &worker->lock);
+		__atomic_store_n(&worker->parked, 0, __ATOMIC_RELAXED);
+		pthread_mutex_unlock(&worker->lock);
+	}
+
+	return NULL;
+}
+
+static void TPOOL_Notify(TPOOL_Worker_t *worker)
+{
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+	if (__atomic_load_n(&worker->parked, __ATOMIC_RELAXED)) {
+		pthread_mutex_lock(&worker->lock);
+		pthread_cond_signal(&worker->wake);
+		pthread_mutex_unlock(&worker->lock);
+	}
+}
+
+static void TPOOL_Reclaim(TPOOL_t *pool, TPOOL_Worker_t *worker)
+{
+	while (!SFIFO_IsEmpty(tpool_done, &worker->doneQueue)) {
+		MEMPOOL_Free(tpool_task, &pool->tasks, SFIFO_Pop(tpool_done, &worker->doneQueue));
+		worker->outstanding--;
+	}
+}
+
+static TPOOL_Worker_t *TPOOL_Select(TPOOL_t *pool)
+{
+	TPOOL_Worker_t *worker;
+	size_t i, load, bestLoad = TPOOL_QUEUE_SIZE;
+	size_t best = 0;
+
+	if (pool->policy == TPOOL_POLICY_LEAST_LOADED) {
+		for (i=0; i<pool->numWorkers; i++) {
+			load = SFIFO_Size(tpool_run, &pool->workers[i].runQueue);
+			if (load < bestLoad) {
+				bestLoad = load;
+				best = i;
+				if (load == 0)
+					break;
+			}
+		}
+
+		worker = &pool->workers[best];
+		TPOOL_Reclaim(pool, worker);
+		return ((bestLoad < TPOOL_QUEUE_SIZE) &&
+		        (worker->outstanding < TPOOL_QUEUE_SIZE)) ? worker : NULL;
+	}
+
+	/* Round robin, skipping over workers whose queue is full */
+	for (i=0; i<pool->numWorkers; i++) {
+		worker = &pool->workers[pool->next];
+		pool->next = (pool->next + 1) % pool->numWorkers;
+
+		TPOOL_Reclaim(pool, worker);
+		if (!SFIFO_IsFull(tpool_run, &worker->runQueue) &&
+		    (worker->outstanding < TPOOL_QUEUE_SIZE))
+			return worker;
+	}
+
+	return NULL;
+}
+
+int TPOOL_Init(TPOOL_t *pool, size_t numWorkers, TPOOL_Policy_t policy)
+{
+	size_t i;
+	int result;
+
+	if ((pool == NULL) || (numWorkers == 0) || (numWorkers > TPOOL_MAX_WORKERS))
+		return -EINVAL;
+
+	MEMPOOL_Init(tpool_task, &pool->tasks);
+	pool->numWorkers = 0;
+	pool->next = 0;
+	pool->policy = policy;
+
+	for (i=0; i<numWorkers; i++) {
+		TPOOL_Worker_t *worker = &pool->workers[i];
+
+		SFIFO_Init(tpool_run, &worker->runQueue);
+		SFIFO_Init(tpool_done, &worker->doneQueue);
+		pthread_mutex_init(&worker->lock, NULL);
+		pthread_cond_init(&worker->wake, NULL);
+		worker->outstanding = 0;
+		worker->parked = 0;
+		worker->stop = 0;
+
+		result = pthread_create(&worker->thread, NULL, TPOOL_WorkerMain, worker);
+		if (result != 0) {
+			pthread_cond_destroy(&worker->wake);
+			pthread_mutex_destroy(&worker->lock);
+			TPOOL_Destroy(pool);
+			return -result;
+		}
+
+		pool->numWorkers++;
+	}
+
+	return 0;
+}
+
+int TPOOL_Submit(TPOOL_t *pool, TPOOL_Func_t func, void *arg)
+{
+	TPOOL_Worker_t *worker;
+	TPOOL_Task_t *task;
+
+	if ((pool == NULL) || (func == NULL))
+		return -EINVAL;
+
+	worker = TPOOL_Select(pool);
+	if (worker == NULL)
+		return -EAGAIN;
+
+	/* Can't fail: TPOOL_Select only returns a worker holding fewer than
+	 * TPOOL_QUEUE_SIZE descriptors, and the pool has that many per worker.
+	 */
+	task = MEMPOOL_Alloc(tpool_task, &pool->tasks);
+	if (task == NULL)
+		return -ENOMEM;
+
+	task->func = func;
+	task->arg = arg;
+	worker->outstanding++;
+
+	SFIFO_Push(tpool_run, &worker->runQueue, task);
+	TPOOL_Notify(worker);
+
+	return 0;
+}
+
+void TPOOL_Wait(TPOOL_t *pool)
+{
+	size_t i;
+
+	for (i=0; i<pool->numWorkers; i++) {
+		TPOOL_Worker_t *worker = &pool->workers[i];
+
+		/* SFIFO_Size does an acquire load of the consumer's counter, so the
+		 * worker's writes from the tasks are visible once it reads zero.
+		 */
+		while (SFIFO_Size(tpool_run, &worker->runQueue) != 0)
+			sched_yield();
+
+		TPOOL_Reclaim(pool, worker);
+	}
+}
+
+void TPOOL_Destroy(TPOOL_t *pool)
+{
+	size_t i;
+
+	for (i=0; i<pool->numWorkers; i++) {
+		TPOOL_Worker_t *worker = &pool->workers[i];
+
+		__atomic_store_n(&worker->stop, 1, __ATOMIC_RELEASE);
+		pthread_mutex_lock(&worker->lock);
+		pthread_cond_signal(&worker->wake);
+		pthread_mutex_unlock(&worker->lock);
+	}
+
+	for (i=0; i<pool->numWorkers; i++) {
+		TPOOL_Worker_t *worker = &pool->workers[i];
+
+		pthread_join(worker->thread, NULL);
+		TPOOL_Reclaim(pool, worker);
+		pthread_cond_destroy(&worker->wake);
+		pthread_mutex_destroy(&worker->lock);
+	}
+
+	pool->numWorkers = 0;
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2015 Jason Schmidlapp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef THREADPOOL_H_
+#define THREADPOOL_H_
+
+/*
+ * Fixed-size thread pool executor.  All memory is part of the TPOOL_t structure, so the
+ * pool can be statically allocated like any other container in this collection.
+ *
+ * Each worker thread owns a pair of simple (single producer, single consumer) FIFOs:
+ *
+ *   runQueue  - task descriptors handed from the submitting thread to the worker
+ *   doneQueue - completed descriptors handed back so the submitter can free them
+ *
+ * Task descriptors come from a MEMPOOL that is only ever touched by the submitting
+ * thread, so no locks are needed on the hot path.  This also means there must be exactly
+ * one submitting thread (the one calling TPOOL_Submit/TPOOL_Wait).
+ *
+ * A worker pushes each finished descriptor to its doneQueue before releasing its
+ * runQueue slot, so the two queues can briefly hold the same descriptor and a refilled
+ * runQueue alone does not bound the doneQueue.  The submitter therefore also counts every
+ * descriptor it has handed to a worker until it is reclaimed from the doneQueue, and
+ * only submits to a worker whose runQueue is not full and whose count is below
+ * TPOOL_QUEUE_SIZE.  This bounds both queues and the descriptor pool.
+ *
+ * Workers dequeue in batches of up to TPOOL_BATCH_SIZE tasks.  A worker that finds its
+ * queue empty spins for TPOOL_SPIN_COUNT iterations and then parks on a condition
+ * variable; the submitter only takes the worker's lock when it sees the worker parked.
+ *
+ * Usage:
+ *
+ * static TPOOL_t pool;
+ *
+ * TPOOL_Init(&pool, 4, TPOOL_POLICY_LEAST_LOADED);
+ * TPOOL_Submit(&pool, myFunc, myArg);    // -EAGAIN if the chosen queue(s) are full
+ * TPOOL_Wait(&pool);                     // blocks until every submitted task has run
+ * TPOOL_Destroy(&pool);
+ */
+
+#include <stddef.h>
+#include <pthread.h>
+
+#include "simple_fifo.h"
+#include "mempool.h"
+
+#ifndef TPOOL_MAX_WORKERS
+#define TPOOL_MAX_WORKERS 16
+#endif
+
+/* Must be a power of two (see simple_fifo.h) */
+#ifndef TPOOL_QUEUE_SIZE
+#define TPOOL_QUEUE_SIZE 256
+#endif
+
+#ifndef TPOOL_BATCH_SIZE
+#define TPOOL_BATCH_SIZE 32
+#endif
+
+#ifndef TPOOL_SPIN_COUNT
+#define TPOOL_SPIN_COUNT 1000
+#endif
+
+typedef void (*TPOOL_Func_t)(void *arg);
+
+typedef struct {
+	TPOOL_Func_t func;
+	void        *arg;
+} TPOOL_Task_t;
+
+typedef TPOOL_Task_t *TPOOL_TaskPtr_t;
+
+typedef enum {
+	TPOOL_POLICY_ROUND_ROBIN,
+	TPOOL_POLICY_LEAST_LOADED
+} TPOOL_Policy_t;
+
+DECLARE_SIMPLE_FIFO(TPOOL_TaskPtr_t, tpool_run, TPOOL_QUEUE_SIZE)
+DECLARE_SIMPLE_FIFO(TPOOL_TaskPtr_t, tpool_done, TPOOL_QUEUE_SIZE)
+DECLARE_MEMPOOL(TPOOL_Task_t, TPOOL_MAX_WORKERS * TPOOL_QUEUE_SIZE, tpool_task)
+
+typedef struct {
+	SFIFO(tpool_run)  runQueue;
+	SFIFO(tpool_done) doneQueue;
+	pthread_t         thread;
+	pthread_mutex_t   lock;
+	pthread_cond_t    wake;
+	size_t            outstanding;  /* submitter only: submitted and not yet reclaimed */
+	int               parked;
+	int               stop;
+} TPOOL_Worker_t;
+
+typedef struct {
+	TPOOL_Worker_t      workers[TPOOL_MAX_WORKERS];
+	MEMPOOL(tpool_task) tasks;
+	size_t              numWorkers;
+	size_t              next;
+	TPOOL_Policy_t      policy;
+} TPOOL_t;
+
+int  TPOOL_Init(TPOOL_t *pool, size_t numWorkers, TPOOL_Policy_t policy);
+int  TPOOL_Submit(TPOOL_t *pool, TPOOL_Func_t func, void *arg);
+void TPOOL_Wait(TPOOL_t *pool);
+void TPOOL_Destroy(TPOOL_t *pool);
+
+#endif // THREADPOOL_H_
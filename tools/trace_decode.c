@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2015 Jason Schmidlapp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Decodes a TRACE_Dump file into a single timeline, merging the per-thread rings by
+ * timestamp.
+ *
+ * Usage: trace_decode [-c] [-e eventnames] dumpfile
+ *
+ *   -c  CSV output (tsc,delta,thread,event,arg0,arg1) instead of aligned text
+ *   -e  file of "id name" lines used to print event names instead of numbers
+ *
+ * Times are printed relative to the earliest record, in timestamp ticks.
+ *
+ * Build: cc -O2 -I.. trace_decode.c -o trace_decode
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../trace.h"
+
+#define MAX_EVENT_NAMES 1024
+
+typedef struct {
+	TRACE_Record_t rec;
+	uint32_t       thread;
+} Entry_t;
+
+static char threadNames[TRACE_MAX_THREADS][TRACE_NAME_LEN];
+
+static struct {
+	uint64_t id;
+	char     name[32];
+} eventNames[MAX_EVENT_NAMES];
+static size_t numEventNames;
+
+static int cmp_entry(const void *a, const void *b)
+{
+	const Entry_t *x = a, *y = b;
+
+	if (x->rec.tsc != y->rec.tsc)
+		return (x->rec.tsc > y->rec.tsc) ? 1 : -1;
+	return (x->thread > y->thread) - (x->thread < y->thread);
+}
+
+static const char *event_name(uint64_t id)
+{
+	static char buf[24];
+	size_t i;
+
+	for (i=0; i<numEventNames; i++) {
+		if (eventNames[i].id == id)
+			return eventNames[i].name;
+	}
+
+	snprintf(buf, sizeof(buf), "%llu", (unsigned long long) id);
+	return buf;
+}
+
+static int load_event_names(const char *path)
+{
+	FILE *fp = fopen(path, "r");
+	unsigned long long id;
+	char name[32];
+
+	if (fp == NULL)
+		return -1;
+
+	while ((numEventNames < MAX_EVENT_NAMES) && (fscanf(fp, "%llu %31s", &id, name) == 2)) {
+		eventNames[numEventNames].id = id;
+		strcpy(eventNames[numEventNames].name, name);
+		numEventNames++;
+	}
+
+	fclose(fp);
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	TRACE_FileHeader_t header;
+	Entry_t *entries = NULL;
+	size_t numEntries = 0, i;
+	uint64_t first, prev;
+	int csv = 0, opt;
+	unsigned t;
+	FILE *fp;
+
+	while ((opt = getopt(argc, argv, "ce:")) != -1) {
+		switch (opt) {
+		case 'c':
+			csv = 1;
+			break;
+		case 'e':
+			if (load_event_names(optarg) != 0) {
+				perror(optarg);
+				return 1;
+			}
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-c] [-e eventnames] dumpfile\n", argv[0]);
+			return 1;
+		}
+	}
+
+	if (optind >= argc) {
+		fprintf(stderr, "usage: %s [-c] [-e eventnames] dumpfile\n", argv[0]);
+		return 1;
+	}
+
+	fp = fopen(argv[optind], "rb");
+	if (fp == NULL) {
+		perror(argv[optind]);
+		return 1;
+	}
+
+	if ((fread(&header, sizeof(header), 1, fp) != 1) || (header.magic != TRACE_MAGIC) ||
+	    (header.version != TRACE_VERSION) || (header.numThreads > TRACE_MAX_THREADS)) {
+		fprintf(stderr, "%s: not a trace dump\n", argv[optind]);
+		return 1;
+	}
+
+	for (t=0; t<header.numThreads; t++) {
+		TRACE_ThreadHeader_t threadHeader;
+		uint32_t r;
+
+		if ((fread(&threadHeader, sizeof(threadHeader), 1, fp) != 1) ||
+		    (threadHeader.id >= TRACE_MAX_THREADS)) {
+			fprintf(stderr, "%s: truncated\n", argv[optind]);
+			return 1;
+		}
+
+		memcpy(threadNames[threadHeader.id], threadHeader.name, TRACE_NAME_LEN);
+		threadNames[threadHeader.id][TRACE_NAME_LEN - 1] = '\0';
+		if (threadHeader.dropped)
+			fprintf(stderr, "thread %u (%s): %llu records lost\n", threadHeader.id,
+			        threadNames[threadHeader.id], (unsigned long long) threadHeader.dropped);
+
+		entries = realloc(entries, (numEntries + threadHeader.numRecords) * sizeof(Entry_t));
+		if (entries == NULL) {
+			perror("realloc");
+			return 1;
+		}
+
+		for (r=0; r<threadHeader.numRecords; r++) {
+			if (fread(&entries[numEntries].rec, sizeof(TRACE_Record_t), 1, fp) != 1) {
+				fprintf(stderr, "%s: truncated\n", argv[optind]);
+				return 1;
+			}
+			entries[numEntries++].thread = threadHeader.id;
+		}
+	}
+
+	fclose(fp);
+
+	qsort(entries, numEntries, sizeof(Entry_t), cmp_entry);
+
+	if (csv)
+		printf("tsc,delta,thread,event,arg0,arg1\n");
+
+	first = prev = numEntries ? entries[0].rec.tsc : 0;
+	for (i=0; i<numEntries; i++) {
+		TRACE_Record_t *rec = &entries[i].rec;
+		const char *name = threadNames[entries[i].thread];
+
+		if (csv)
+			printf("%llu,%llu,%s,%s,%llu,%llu\n",
+			       (unsigned long long) (rec->tsc - first), (unsigned long long) (rec->tsc - prev),
+			       name, event_name(rec->event),
+			       (unsigned long long) rec->arg0, (unsigned long long) rec->arg1);
+		else
+			printf("%14llu  +%-10llu %-15s %-20s %llu %llu\n",
+			       (unsigned long long) (rec->tsc - first), (unsigned long long) (rec->tsc - prev),
+			       name, event_name(rec->event),
+			       (unsigned long long) rec->arg0, (unsigned long long) rec->arg1);
+
+		prev = rec->tsc;
+	}
+
+	free(entries);
+	return 0;
+}
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2015 Jason Schmidlapp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "trace.h"
+
+__thread TRACE_Thread_t *TRACE_self;
+
+static TRACE_Thread_t  TRACE_threads[TRACE_MAX_THREADS];
+static int             TRACE_ready[TRACE_MAX_THREADS];
+static unsigned        TRACE_numThreads;
+
+/* Serializes dumps; TRACE_Dump is the single consumer of every ring */
+static pthread_mutex_t TRACE_dumpLock = PTHREAD_MUTEX_INITIALIZER;
+static TRACE_Record_t  TRACE_dumpBuffer[TRACE_RING_SIZE];
+
+int TRACE_ThreadInit(const char *name)
+{
+	unsigned id;
+
+	if (TRACE_self != NULL)
+		return 0;
+
+	id = __atomic_fetch_add(&TRACE_numThreads, 1, __ATOMIC_RELAXED);
+	if (id >= TRACE_MAX_THREADS)
+		return -ENOSPC;
+
+	SFIFO_Init(trace, &TRACE_threads[id].ring);
+	strncpy(TRACE_threads[id].name, name ? name : "", TRACE_NAME_LEN - 1);
+	TRACE_threads[id].name[TRACE_NAME_LEN - 1] = '\0';
+
+	/* Publishes the initialized ring to TRACE_Dump */
+	__atomic_store_n(&TRACE_ready[id], 1, __ATOMIC_RELEASE);
+	TRACE_self = &TRACE_threads[id];
+	return 0;
+}
+
+static int TRACE_WriteAll(int fd, const void *data, size_t len)
+{
+	const char *p = data;
+
+	while (len > 0) {
+		ssize_t result = write(fd, p, len);
+
+		if (result < 0) {
+			if (errno == EINTR)
+				continue;
+			return -errno;
+		}
+
+		p += result;
+		len -= result;
+	}
+
+	return 0;
+}
+
+int TRACE_Dump(int fd)
+{
+	TRACE_FileHeader_t header;
+	unsigned numThreads = __atomic_load_n(&TRACE_numThreads, __ATOMIC_RELAXED);
+	unsigned char isReady[TRACE_MAX_THREADS];
+	unsigned i, ready = 0;
+	int result;
+
+	if (numThreads > TRACE_MAX_THREADS)
+		numThreads = TRACE_MAX_THREADS;
+
+	pthread_mutex_lock(&TRACE_dumpLock);
+
+	/* Threads still being set up are left out; sampled once so the count matches */
+	for (i=0; i<numThreads; i++) {
+		isReady[i] = __atomic_load_n(&TRACE_ready[i], __ATOMIC_ACQUIRE);
+		ready += isReady[i];
+	}
+
+	header.magic = TRACE_MAGIC;
+	header.version = TRACE_VERSION;
+	header.numThreads = ready;
+	result = TRACE_WriteAll(fd, &header, sizeof(header));
+
+	for (i=0; (i<numThreads) && (result == 0); i++) {
+		TRACE_Thread_t *thread = &TRACE_threads[i];
+		TRACE_ThreadHeader_t threadHeader;
+		uint32_t num = 0;
+
+		if (!isReady[i])
+			continue;
+
+		/* Bounded, so a thread that keeps tracing can't keep the dump going forever */
+		while ((num < TRACE_RING_SIZE) &&
+		       (SFIFO_TryPop(trace, &thread->ring, &TRACE_dumpBuffer[num]) == 0))
+			num++;
+
+		threadHeader.id = i;
+		threadHeader.numRecords = num;
+		threadHeader.dropped = SFIFO_Dropped(trace, &thread->ring);
+		memcpy(threadHeader.name, thread->name, TRACE_NAME_LEN);
+
+		result = TRACE_WriteAll(fd, &threadHeader, sizeof(threadHeader));
+		if (result == 0)
+			result = TRACE_WriteAll(fd, TRACE_dumpBuffer, num * sizeof(TRACE_Record_t));
+	}
+
+	pthread_mutex_unlock(&TRACE_dumpLock);
+	return result;
+}
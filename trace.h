@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2015 Jason Schmidlapp
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+/*
+ * Low overhead event tracing for hot paths.  Every thread that traces gets its own
+ * lossy ring (DECLARE_OVERWRITE_SIMPLE_FIFO) of fixed-size records, so recording an
+ * event is a timestamp read and a few stores with no locks, no system calls and no
+ * sharing between threads.  When a ring is full the oldest records are overwritten.
+ *
+ * TRACE_ThreadInit("rx");                // once per thread, claims a ring
+ * TRACE(EV_RX_BURST, numPkts, queueId);  // records {timestamp, event, arg0, arg1}
+ * TRACE_Dump(fd);                        // any thread, writes all rings in binary
+ *
+ * Threads that never called TRACE_ThreadInit record nothing.  Defining TRACE_DISABLE
+ * compiles every TRACE() away.
+ *
+ * TRACE_Dump drains the rings (it is their only consumer), so each record is dumped
+ * once; it may run while other threads keep tracing.  The dump is decoded with
+ * tools/trace_decode, which merges the threads into one time ordered text or CSV
+ * timeline.  Timestamps are FIFO_STATS_Now() ticks (the TSC on x86).
+ *
+ * Rings are statically allocated: TRACE_MAX_THREADS of TRACE_RING_SIZE records (a power
+ * of two).  Both must be the same in trace.c and every file using TRACE().
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "simple_fifo.h"
+
+#ifndef TRACE_MAX_THREADS
+#define TRACE_MAX_THREADS 32
+#endif
+
+#ifndef TRACE_RING_SIZE
+#define TRACE_RING_SIZE 4096
+#endif
+
+#define TRACE_NAME_LEN 16
+
+typedef struct {
+	uint64_t tsc;
+	uint64_t event;
+	uint64_t arg0;
+	uint64_t arg1;
+} TRACE_Record_t;
+
+DECLARE_OVERWRITE_SIMPLE_FIFO(TRACE_Record_t, trace, TRACE_RING_SIZE)
+
+typedef struct {
+	SFIFO(trace) ring;
+	char         name[TRACE_NAME_LEN];
+} TRACE_Thread_t;
+
+/*
+ * Dump format (native byte order): a TRACE_FileHeader_t, then for each thread a
+ * TRACE_ThreadHeader_t followed by numRecords TRACE_Record_t, oldest first.
+ */
+#define TRACE_MAGIC   0x4543415254454443ull   /* "CDETRACE" */
+#define TRACE_VERSION 1
+
+typedef struct {
+	uint64_t magic;
+	uint32_t version;
+	uint32_t numThreads;
+} TRACE_FileHeader_t;
+
+typedef struct {
+	uint32_t id;
+	uint32_t numRecords;
+	uint64_t dropped;     /* overwritten before they could be dumped, since start */
+	char     name[TRACE_NAME_LEN];
+} TRACE_ThreadHeader_t;
+
+extern __thread TRACE_Thread_t *TRACE_self;
+
+int TRACE_ThreadInit(const char *name);
+int TRACE_Dump(int fd);
+
+static inline void TRACE_Record(uint64_t event, uint64_t arg0, uint64_t arg1)
+{
+	TRACE_Record_t rec;
+
+	if (TRACE_self == NULL)
+		return;
+
+	rec.tsc = FIFO_STATS_Now();
+	rec.event = event;
+	rec.arg0 = arg0;
+	rec.arg1 = arg1;
+	SFIFO_Push(trace, &TRACE_self->ring, rec);
+}
+
+#ifdef TRACE_DISABLE
+#define TRACE(event, arg0, arg1) do { } while (0)
+#else
+#define TRACE(event, arg0, arg1) TRACE_Record(event, arg0, arg1)
+#endif
+
+#endif // TRACE_H_